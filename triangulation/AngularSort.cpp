@@ -0,0 +1,144 @@
+#include "AngularSort.h"
+#include "PointKernels.h"
+#include "RadixSort.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Exact counterclockwise order around the origin, points on one ray are ordered by distance.
+// All points lie on or above the origin and those on its level right of it, so along a ray
+// the distance grows with y, or with x on the horizontal ray.
+template <typename Coord>
+struct RayCompare
+{
+    const BasicPointArray<Coord> &points;
+    real ox, oy;
+
+    template <typename Index>
+    bool operator()(Index i1, Index i2) const {
+        real x1 = real(points.x[i1]), y1 = real(points.y[i1]), x2 = real(points.x[i2]), y2 = real(points.y[i2]);
+        real side = orient2d(ox, oy, x1, y1, x2, y2);
+        if (side != 0.0)
+            return side > 0.0;
+        return y1 < y2 || (y1 == y2 && x1 < x2);
+    }
+};
+
+// Runs are tiny unless many points share a ray, insertion sort is enough then
+const size_t INSERTION_SORT_MAX = 32;
+
+// Angles closer than this are compared exactly by the atan2 sort
+const real ATAN2_TOLERANCE = 1e-12;
+
+// Sort the maximal runs of [begin, begin + size) whose neighbours i and i + 1 are linked
+template <typename Iterator, typename Compare, typename Linked>
+void sortRuns(Iterator begin, size_t size, const Compare &compare, Linked linked)
+{
+    size_t run_begin = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (i + 1 < size && linked(i))
+            continue;
+
+        // Resolve the run [run_begin, i]
+        if (i > run_begin) {
+            auto run_first = begin + run_begin, run_end = begin + i + 1;
+            if (i - run_begin < INSERTION_SORT_MAX) {
+                for (auto it = run_first + 1; it != run_end; ++it) {
+                    auto value = *it;
+                    auto hole = it;
+                    for (; hole != run_first && compare(value, *(hole - 1)); --hole)
+                        *hole = *(hole - 1);
+                    *hole = value;
+                }
+            } else {
+                std::stable_sort(run_first, run_end, compare);
+            }
+        }
+        run_begin = i + 1;
+    }
+}
+
+}
+
+template <typename Coord, typename Index>
+void pseudoAngleSort(std::vector<Index> &indices, size_t first, const BasicPointArray<Coord> &points,
+                     size_t origin, ThreadPool *pool, AngularSortBuffers<Index> &buffers)
+{
+    if (indices.size() <= first + 1)
+        return;
+
+    // Positions are kept in 32 bits next to the keys
+    size_t size = indices.size() - first;
+    if (size > size_t(UINT32_MAX)) {
+        atan2Sort(indices, first, points, origin, buffers);
+        return;
+    }
+
+    // Key in the upper half, position in the lower half
+    std::vector<uint64_t> &items = buffers.items;
+    items.resize(size);
+    auto makeKeys = [&](size_t part, unsigned) {
+        size_t begin, end;
+        blockRange(size, pool ? pool->size() : 1, part, begin, end);
+        angleKeys(points, indices.data() + first + begin, end - begin, origin, items.data() + begin);
+        for (size_t i = begin; i < end; ++i)
+            items[i] += begin;
+    };
+    if (pool)
+        pool->run(pool->size(), makeKeys);
+    else
+        makeKeys(0, 0);
+
+    radixSort(items, buffers.scratch, buffers.counts, 32, 32, pool);
+
+    // Keys are rounded, so points in neighbouring buckets may be out of order as well. Runs of
+    // keys at most one apart are sorted again with the exact comparison.
+    std::vector<Index> &order = buffers.order;
+    order.assign(indices.begin() + first, indices.end());
+    typename std::vector<Index>::iterator begin = indices.begin() + first;
+    for (size_t i = 0; i < size; ++i)
+        begin[i] = order[uint32_t(items[i])];
+    RayCompare<Coord> compare = { points, real(points.x[origin]), real(points.y[origin]) };
+    sortRuns(begin, size, compare, [&items](size_t i) {
+        return (items[i + 1] >> 32) - (items[i] >> 32) <= 1;
+    });
+}
+
+template <typename Coord, typename Index>
+void atan2Sort(std::vector<Index> &indices, size_t first, const BasicPointArray<Coord> &points, size_t origin,
+               AngularSortBuffers<Index> &buffers)
+{
+    if (indices.size() <= first + 1)
+        return;
+
+    size_t size = indices.size() - first;
+    real ox = real(points.x[origin]), oy = real(points.y[origin]);
+
+    std::vector<std::pair<real, Index> > &items = buffers.angles;
+    items.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        Index index = indices[first + i];
+        items[i] = std::make_pair(atan2(real(points.y[index]) - oy, real(points.x[index]) - ox), index);
+    }
+    std::sort(items.begin(), items.end());
+
+    // The rounding of the angles is far below ATAN2_TOLERANCE, so only points whose angles are
+    // that close can be out of order
+    typename std::vector<Index>::iterator begin = indices.begin() + first;
+    for (size_t i = 0; i < size; ++i)
+        begin[i] = items[i].second;
+    RayCompare<Coord> compare = { points, ox, oy };
+    sortRuns(begin, size, compare, [&items](size_t i) {
+        return items[i + 1].first - items[i].first <= ATAN2_TOLERANCE;
+    });
+}
+
+#define INSTANTIATE_ANGULAR_SORT(Coord, Index) \
+    template void pseudoAngleSort(std::vector<Index>&, size_t, const BasicPointArray<Coord>&, size_t, ThreadPool*, \
+                                  AngularSortBuffers<Index>&); \
+    template void atan2Sort(std::vector<Index>&, size_t, const BasicPointArray<Coord>&, size_t, AngularSortBuffers<Index>&);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_ANGULAR_SORT)
@@ -0,0 +1,40 @@
+#ifndef ANGULARSORT_H
+#define ANGULARSORT_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "PointArray.h"
+
+class ThreadPool;
+
+enum AngularSortMethod
+{
+    SORT_ATAN2,         // std::sort of atan2 angles (original implementation)
+    SORT_PSEUDO_ANGLE   // Radix sort of precomputed pseudo-angle keys
+};
+
+// Buffers of the angular sorts, kept by the caller to reuse them
+template <typename Index>
+struct AngularSortBuffers
+{
+    std::vector<uint64_t> items, scratch;
+    std::vector<size_t> counts;
+    std::vector<Index> order;
+    std::vector<std::pair<real, Index> > angles;
+};
+
+// Sort indices[first..] counterclockwise around points[origin], points on one ray are ordered
+// by distance. No point may lie below the origin, nor on its level left of it. The rounded
+// angles only presort, points they cannot separate safely are ordered with orient2d.
+template <typename Coord, typename Index>
+void pseudoAngleSort(std::vector<Index> &indices, size_t first, const BasicPointArray<Coord> &points,
+                     size_t origin, ThreadPool *pool, AngularSortBuffers<Index> &buffers);
+
+// The same order from atan2 angles
+template <typename Coord, typename Index>
+void atan2Sort(std::vector<Index> &indices, size_t first, const BasicPointArray<Coord> &points, size_t origin,
+               AngularSortBuffers<Index> &buffers);
+
+#endif // ANGULARSORT_H
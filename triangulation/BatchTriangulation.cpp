@@ -0,0 +1,170 @@
+#include "BatchTriangulation.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+namespace {
+
+// Sets are handed out in chunks of about this many points, so that small sets do not all
+// contend for the counter of the pool
+const size_t BATCH_CHUNK_POINTS = 8192;
+
+// Results of the chunks a worker has done, one after another. Point indices are already those
+// of the batch, triangle and half-edge indices are still local to their set.
+template <typename Index>
+struct WorkerOutput
+{
+    std::vector<std::pair<Index,Index> > edges;
+    BasicTriangleMesh<Index> mesh;
+};
+
+// Where the results of a set were left
+struct SetPlacement
+{
+    unsigned worker;
+    size_t edges, triangles;
+};
+
+}
+
+template <typename Coord, typename Index>
+bool triangulateBatch(const Coord *x, const Coord *y, const size_t *offsets, size_t set_count,
+                      const TriangulationOptions &options, BasicBatchResult<Index> &result)
+{
+    result.clear();
+    size_t point_count = offsets[set_count];
+    if (point_count > size_t(std::numeric_limits<Index>::max()))
+        return false;
+
+    ThreadPool *pool = options.pool;
+    std::unique_ptr<ThreadPool> own_pool;
+    if (!pool && options.threads != 1) {
+        own_pool.reset(new ThreadPool(options.threads));
+        pool = own_pool.get();
+    }
+    unsigned workers = pool ? pool->size() : 1;
+
+    // Every set is triangulated on a single thread, the sets themselves are the parallelism
+    TriangulationOptions set_options = options;
+    set_options.threads = 1;
+    set_options.pool = nullptr;
+
+    std::vector<std::unique_ptr<BasicLayerTriangulation<Coord, Index> > > triangulations(workers);
+    for (unsigned worker = 0; worker < workers; ++worker)
+        triangulations[worker].reset(new BasicLayerTriangulation<Coord, Index>(set_options));
+    std::vector<WorkerOutput<Index> > outputs(workers);
+
+    // Consecutive sets up to the chunk size, smaller chunks when there are few points per worker
+    size_t chunk_points = std::min(BATCH_CHUNK_POINTS, point_count / (4 * workers) + 1);
+    std::vector<size_t> chunks(1, 0);
+    for (size_t set = 0; set < set_count; ++set) {
+        if (offsets[set + 1] - offsets[chunks.back()] >= chunk_points)
+            chunks.push_back(set + 1);
+    }
+    if (chunks.back() != set_count)
+        chunks.push_back(set_count);
+
+    const Index NONE = result.mesh.NONE;
+    bool half_edges = options.topology == MESH_HALF_EDGES;
+    if (half_edges)
+        result.mesh.vertexEdges.assign(point_count, NONE);
+    result.edgeOffsets.assign(set_count + 1, 0);
+    result.triangleOffsets.assign(set_count + 1, 0);
+    result.layerCounts.assign(set_count, 0);
+    std::vector<SetPlacement> placements(set_count);
+
+    // Triangulate, leaving the counts of every set in the offsets
+    runTasks(pool, chunks.size() - 1, [&](size_t chunk, unsigned worker) {
+        BasicLayerTriangulation<Coord, Index> &triangulation = *triangulations[worker];
+        WorkerOutput<Index> &out = outputs[worker];
+
+        for (size_t set = chunks[chunk]; set < chunks[chunk + 1]; ++set) {
+            size_t first = offsets[set], count = offsets[set + 1] - first;
+            triangulation.triangulate(x + first, y + first, count);
+
+            SetPlacement &placement = placements[set];
+            placement.worker = worker;
+            placement.edges = out.edges.size();
+            placement.triangles = out.mesh.size();
+
+            for (const std::pair<Index,Index> &edge : triangulation.edges)
+                out.edges.push_back(std::make_pair(Index(edge.first + first), Index(edge.second + first)));
+            if (!triangulation.edgesIncludeSides()) {
+                forEachLayerSide(triangulation.layers, [&out, first](Index i1, Index i2) {
+                    out.edges.push_back(std::make_pair(Index(i1 + first), Index(i2 + first)));
+                });
+            }
+
+            const BasicTriangleMesh<Index> &mesh = triangulation.mesh;
+            for (Index vertex : mesh.triangles)
+                out.mesh.triangles.push_back(Index(vertex + first));
+            out.mesh.neighbors.insert(out.mesh.neighbors.end(), mesh.neighbors.begin(), mesh.neighbors.end());
+            out.mesh.halfedges.insert(out.mesh.halfedges.end(), mesh.halfedges.begin(), mesh.halfedges.end());
+            if (half_edges)
+                std::copy(mesh.vertexEdges.begin(), mesh.vertexEdges.end(), result.mesh.vertexEdges.begin() + first);
+
+            result.edgeOffsets[set + 1] = out.edges.size() - placement.edges;
+            result.triangleOffsets[set + 1] = mesh.size();
+            result.layerCounts[set] = triangulation.layers.size();
+        }
+    });
+
+    for (size_t set = 0; set < set_count; ++set) {
+        result.edgeOffsets[set + 1] += result.edgeOffsets[set];
+        result.triangleOffsets[set + 1] += result.triangleOffsets[set];
+    }
+    size_t triangle_count = result.triangleOffsets.back();
+    result.edges.resize(result.edgeOffsets.back());
+    result.mesh.triangles.resize(3 * triangle_count);
+    if (options.topology != MESH_EDGES_ONLY)
+        result.mesh.neighbors.resize(3 * triangle_count);
+    if (half_edges)
+        result.mesh.halfedges.resize(3 * triangle_count);
+
+    // Move the results into place, shifting the triangle and half-edge indices by those of the set
+    runTasks(pool, chunks.size() - 1, [&](size_t chunk, unsigned) {
+        for (size_t set = chunks[chunk]; set < chunks[chunk + 1]; ++set) {
+            const SetPlacement &placement = placements[set];
+            const WorkerOutput<Index> &out = outputs[placement.worker];
+
+            size_t edges = result.edgeOffsets[set], edge_count = result.edgeOffsets[set + 1] - edges;
+            std::copy(out.edges.begin() + placement.edges, out.edges.begin() + placement.edges + edge_count,
+                      result.edges.begin() + edges);
+
+            size_t triangles = result.triangleOffsets[set];
+            size_t from = 3 * placement.triangles, to = 3 * triangles;
+            size_t slots = 3 * (result.triangleOffsets[set + 1] - triangles);
+            std::copy(out.mesh.triangles.begin() + from, out.mesh.triangles.begin() + from + slots,
+                      result.mesh.triangles.begin() + to);
+            if (options.topology == MESH_EDGES_ONLY)
+                continue;
+
+            for (size_t i = 0; i < slots; ++i) {
+                Index neighbor = out.mesh.neighbors[from + i];
+                result.mesh.neighbors[to + i] = neighbor == NONE ? NONE : Index(neighbor + triangles);
+            }
+            if (!half_edges)
+                continue;
+
+            for (size_t i = 0; i < slots; ++i) {
+                Index twin = out.mesh.halfedges[from + i];
+                result.mesh.halfedges[to + i] = twin == NONE ? NONE : Index(twin + to);
+            }
+            for (size_t point = offsets[set]; point < offsets[set + 1]; ++point) {
+                Index edge = result.mesh.vertexEdges[point];
+                if (edge != NONE)
+                    result.mesh.vertexEdges[point] = Index(edge + to);
+            }
+        }
+    });
+
+    return true;
+}
+
+#define INSTANTIATE_BATCH(Coord, Index) \
+    template bool triangulateBatch(const Coord*, const Coord*, const size_t*, size_t, const TriangulationOptions&, \
+                                   BasicBatchResult<Index>&);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_BATCH)
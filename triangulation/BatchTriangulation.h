@@ -0,0 +1,49 @@
+#ifndef BATCHTRIANGULATION_H
+#define BATCHTRIANGULATION_H
+
+#include <utility>
+#include <vector>
+
+#include "LayerTriangulation.h"
+
+// Triangulations of many independent point sets, stored back to back. Every set has its own
+// range of the flat arrays below; point indices refer to the batch input and triangle indices
+// to the batch triangles, so the arrays can be used as they are.
+template <typename Index>
+struct BasicBatchResult
+{
+    // Edges of set s are edges[edgeOffsets[s]] .. edges[edgeOffsets[s + 1] - 1], every edge of
+    // its triangulation once, the layer sides included
+    std::vector<std::pair<Index,Index> > edges;
+    std::vector<size_t> edgeOffsets;
+
+    // Triangles of set s are triangleOffsets[s] .. triangleOffsets[s + 1] - 1, laid out as
+    // in BasicTriangleMesh. Neighbors and half-edges are filled as the topology option asks,
+    // vertexEdges is indexed by the batch points.
+    BasicTriangleMesh<Index> mesh;
+    std::vector<size_t> triangleOffsets;
+
+    // Number of convex layers of every set
+    std::vector<size_t> layerCounts;
+
+    void clear() {
+        edges.clear();
+        edgeOffsets.clear();
+        mesh.clear();
+        triangleOffsets.clear();
+        layerCounts.clear();
+    }
+};
+
+typedef BasicBatchResult<int> BatchResult;
+
+// Triangulate the point sets given in CSR layout: set s consists of the points offsets[s] ..
+// offsets[s + 1] - 1 of x and y, offsets holds set_count + 1 ascending values starting at 0.
+// Sets are handed out in chunks to the workers of options.pool (or of an own pool for
+// options.threads), each worker reusing one triangulation and its buffers for all its sets.
+// Returns false if the points do not fit Index.
+template <typename Coord, typename Index>
+bool triangulateBatch(const Coord *x, const Coord *y, const size_t *offsets, size_t set_count,
+                      const TriangulationOptions &options, BasicBatchResult<Index> &result);
+
+#endif // BATCHTRIANGULATION_H
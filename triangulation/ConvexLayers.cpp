@@ -0,0 +1,467 @@
+#include "ConvexLayers.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <limits>
+
+template <typename Node>
+void HullTree<Node>::build(const real *xs, const real *ys, Node count, bool lower)
+{
+    this->count = count;
+    this->lower = lower;
+    coords.resize(2 * count);
+    size = 1;
+    while (size < count)
+        size <<= 1;
+
+    for (Node leaf = 0; leaf < count; ++leaf) {
+        Node pos = position(leaf);
+        coords[2 * leaf] = lower ? -xs[pos] : xs[pos];
+        coords[2 * leaf + 1] = lower ? -ys[pos] : ys[pos];
+    }
+
+    Bridge none = { -1, -1 };
+    bridges.assign(size, none);
+    leaves.assign(size, 0);
+    std::fill(leaves.begin(), leaves.begin() + count, 1);
+
+    for (Node node = size - 1; node > 0; --node) {
+        update(node);
+    }
+}
+
+template <typename Node>
+void HullTree<Node>::erase(const std::vector<Node> &positions)
+{
+    nodes.clear();
+
+    for (Node pos : positions) {
+        Node leaf = position(pos);
+        leaves[leaf] = 0;
+        nodes.push_back((leaf + size) >> 1);
+    }
+
+    // Recompute the touched nodes level by level, every node once
+    while (!nodes.empty() && nodes[0] > 0) {
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+        parents.clear();
+        for (Node node : nodes) {
+            update(node);
+            if (node > 1)
+                parents.push_back(node >> 1);
+        }
+        nodes.swap(parents);
+    }
+}
+
+template <typename Node>
+void HullTree<Node>::hull(std::vector<Node> &out) const
+{
+    if (empty())
+        return;
+
+    Node root = canonical(1);
+    if (isLeaf(root)) {
+        out.push_back(position(root - size));
+        return;
+    }
+    report(root, leftmost(root), rightmost(root), out);
+}
+
+template <typename Node>
+Node HullTree<Node>::canonical(Node node) const
+{
+    while (!isLeaf(node)) {
+        bool l = alive(2 * node), r = alive(2 * node + 1);
+        if (l && r)
+            break;
+        node = l ? 2 * node : 2 * node + 1;
+    }
+    return node;
+}
+
+template <typename Node>
+Node HullTree<Node>::rightmost(Node node) const
+{
+    while (!isLeaf(node))
+        node = alive(2 * node + 1) ? 2 * node + 1 : 2 * node;
+    return node - size;
+}
+
+template <typename Node>
+Node HullTree<Node>::leftmost(Node node) const
+{
+    while (!isLeaf(node))
+        node = alive(2 * node) ? 2 * node : 2 * node + 1;
+    return node - size;
+}
+
+template <typename Node>
+void HullTree<Node>::update(Node node)
+{
+    bool l = alive(2 * node), r = alive(2 * node + 1);
+    if (l && r) {
+        bridge(node);
+    } else if (l || r) {
+        Node child = l ? 2 * node : 2 * node + 1;
+        if (isLeaf(child)) {
+            bridges[node].left = bridges[node].right = child - size;
+        } else {
+            bridges[node] = bridges[child];
+        }
+    } else {
+        bridges[node].left = bridges[node].right = -1;
+    }
+}
+
+template <typename Node>
+real HullTree<Node>::orientation(Node l1, Node l2, Node l3) const
+{
+    countOrientationTest();
+    return orient2d(x(l1), y(l1), x(l2), y(l2), x(l3), y(l3));
+}
+
+template <typename Node>
+void HullTree<Node>::bridge(Node node)
+{
+    Node u = canonical(2 * node), v = canonical(2 * node + 1);
+
+    // Vertical line between the leaf ranges of the two subtrees
+    Node span = size >> (63 - __builtin_clzll(uint64_t(node)));
+    Node split_leaf = node * span + span / 2 - size;
+    real split = (x(split_leaf - 1) + x(split_leaf)) / 2;
+
+    // Descend both subtrees with the case analysis of Overmars and van Leeuwen. (a, b) is the
+    // bridge of u and (c, d) the bridge of v, the bridge of node is sought as (p, q).
+    while (!isLeaf(u) || !isLeaf(v)) {
+        Node a = isLeaf(u) ? u - size : bridges[u].left,  b = isLeaf(u) ? u - size : bridges[u].right;
+        Node c = isLeaf(v) ? v - size : bridges[v].left,  d = isLeaf(v) ? v - size : bridges[v].right;
+
+        if (!isLeaf(u) && orientation(a, b, c) >= 0) {
+            // c is above the line ab, so p is at or left of a
+            u = canonical(2 * u);
+        } else if (!isLeaf(v) && orientation(c, d, b) >= 0) {
+            // b is above the line cd, so q is at or right of d
+            v = canonical(2 * v + 1);
+        } else if (isLeaf(u)) {
+            v = canonical(2 * v);
+        } else if (isLeaf(v)) {
+            u = canonical(2 * u + 1);
+        } else {
+            // Both candidate edges are below each other: the side of the split line holding
+            // the intersection of lines ab and cd tells which half can be discarded
+            if (intersectsLeftOf(x(a), y(a), x(b), y(b), x(c), y(c), x(d), y(d), split))
+                u = canonical(2 * u + 1);
+            else
+                v = canonical(2 * v);
+        }
+    }
+
+    bridges[node].left = u - size;
+    bridges[node].right = v - size;
+}
+
+template <typename Node>
+void HullTree<Node>::report(Node node, Node from, Node to, std::vector<Node> &out) const
+{
+    node = canonical(node);
+    if (isLeaf(node)) {
+        out.push_back(position(node - size));
+        return;
+    }
+
+    if (to <= bridges[node].left) {
+        report(2 * node, from, to, out);
+    } else if (from >= bridges[node].right) {
+        report(2 * node + 1, from, to, out);
+    } else {
+        report(2 * node, from, bridges[node].left, out);
+        report(2 * node + 1, bridges[node].right, to, out);
+    }
+}
+
+template <typename Node>
+void HullTree<Node>::sidePoints(Node from, Node to, std::vector<Node> &out) const
+{
+    Node first = position(from), last = position(to);
+    if (last - first > 1)
+        sidePoints(1, 0, size, first, last, out);
+}
+
+template <typename Node>
+Node HullTree<Node>::extreme(Node node, real dx, real dy) const
+{
+    // Along the hull of a subtree the distance left of the direction rises to its maximum and falls
+    // again, so the bridge tells which child holds the maximum
+    node = canonical(node);
+    while (!isLeaf(node)) {
+        Node a = bridges[node].left, b = bridges[node].right;
+        real rise = orient2d(0, 0, dx, dy, x(b) - x(a), y(b) - y(a));
+        if (rise == 0)
+            return a;
+        node = canonical(rise > 0 ? 2 * node + 1 : 2 * node);
+    }
+    return node - size;
+}
+
+template <typename Node>
+void HullTree<Node>::sidePoints(Node node, Node begin, Node end, Node first, Node last, std::vector<Node> &out) const
+{
+    if (end <= first + 1 || begin >= last || !alive(node))
+        return;
+
+    // No point between first and last lies above their side, so a subtree within that range
+    // holds points on it only if its farthest point is on it
+    if (begin > first && end <= last) {
+        if (orientation(first, last, extreme(node, x(last) - x(first), y(last) - y(first))) < 0)
+            return;
+        if (isLeaf(node)) {
+            out.push_back(position(node - size));
+            return;
+        }
+    }
+    Node middle = begin + (end - begin) / 2;
+    sidePoints(2 * node, begin, middle, first, last, out);
+    sidePoints(2 * node + 1, middle, end, first, last, out);
+}
+
+template <typename Coord, typename Index>
+void peelConvexLayers(const BasicPointArray<Coord> &points, const Index *subset, size_t subset_count, size_t origin,
+                      bool outermost, LayerList<Index> &layers, PeelBuffers<Index> &buffers,
+                      const PeelLimits &limits)
+{
+    typedef HullNode<Index> Node;
+
+    Node count = (Node)subset_count;
+    if (count == 0)
+        return;
+
+    std::vector<Index> &order = buffers.order;
+    order.assign(subset, subset + subset_count);
+    std::sort(order.begin(), order.end(), [&points](Index i1, Index i2) {
+        return points.x[i1] < points.x[i2] || (points.x[i1] == points.x[i2] && points.y[i1] < points.y[i2]);
+    });
+
+    std::vector<real> &xs = buffers.xs, &ys = buffers.ys;
+    xs.resize(count);
+    ys.resize(count);
+    for (Node pos = 0; pos < count; ++pos) {
+        xs[pos] = real(points.x[order[pos]]);
+        ys[pos] = real(points.y[order[pos]]);
+    }
+
+    HullTree<Node> &upper = buffers.upper, &lower = buffers.lower;
+    upper.build(xs.data(), ys.data(), count, false);
+    lower.build(xs.data(), ys.data(), count, true);
+
+    std::vector<Node> &chains = buffers.chains, &cycle = buffers.cycle;
+    size_t first_layer = layers.size();
+
+    while (!upper.empty() && layers.size() - first_layer < limits.maxLayers) {
+        // Clockwise cycle: upper hull left to right, then lower hull back without the shared ends,
+        // with the points on the sides. A hull that is a segment is both chains, it is walked once.
+        chains.clear();
+        upper.hull(chains);
+        size_t upper_size = chains.size();
+        lower.hull(chains);
+        bool segment = upper_size == 2 && chains.size() == 4;
+        cycle.clear();
+        for (size_t i = 0; i < upper_size; ++i) {
+            cycle.push_back(chains[i]);
+            if (i + 1 < upper_size)
+                upper.sidePoints(chains[i], chains[i + 1], cycle);
+        }
+        size_t lower_first = cycle.size();
+        for (size_t i = upper_size; i + 1 < chains.size() && !segment; ++i) {
+            if (i > upper_size)
+                cycle.push_back(chains[i]);
+            lower.sidePoints(chains[i], chains[i + 1], cycle);
+        }
+
+        // Copies of the shared ends lie on the sides of both chains, the upper one holds them
+        Node left = chains[0], right = chains[upper_size - 1];
+        cycle.erase(std::remove_if(cycle.begin() + lower_first, cycle.end(), [&xs, &ys, left, right](Node pos) {
+            return (xs[pos] == xs[left] && ys[pos] == ys[left]) || (xs[pos] == xs[right] && ys[pos] == ys[right]);
+        }), cycle.end());
+        std::reverse(cycle.begin(), cycle.end());
+        if (cycle.size() < limits.minLayerSize)
+            break;
+
+        // Choose the first vertex as the Graham scans do
+        size_t start = 0;
+        for (size_t i = 1; i < cycle.size(); ++i) {
+            Index p = order[cycle[i]], s = order[cycle[start]];
+            if (outermost && layers.size() == first_layer) {
+                if (points.y[p] < points.y[s] || (points.y[p] == points.y[s] && points.x[p] < points.x[s]))
+                    start = i;
+            } else {
+                // Points on one ray around the lowest point are ordered by y, then by x
+                real cross = get_side(points, origin, p, s);
+                if (cross > 0 || (cross == 0 && (points.y[p] < points.y[s] || (points.y[p] == points.y[s] && points.x[p] < points.x[s]))))
+                    start = i;
+            }
+        }
+        // A segment is a path between its ends, the scans walk it from the first one
+        if (segment && start > 0) {
+            std::reverse(cycle.begin(), cycle.end());
+            start = 0;
+        }
+        std::rotate(cycle.begin(), cycle.begin() + start, cycle.end());
+
+        std::transform(cycle.begin(), cycle.end(), layers.addLayer(cycle.size()), [&order](Node pos) {
+            return order[pos];
+        });
+
+        upper.erase(cycle);
+        lower.erase(cycle);
+    }
+}
+
+template <typename Coord, typename Index>
+BasicConvexLayers<Coord, Index>::BasicConvexLayers(const Coord *x, const Coord *y, size_t count, const PeelLimits &limits)
+{
+    peel(x, y, count, limits);
+}
+
+template <typename Coord, typename Index>
+void BasicConvexLayers<Coord, Index>::peel(const Coord *x, const Coord *y, size_t count, const PeelLimits &limits)
+{
+    coordinates.view(x, y, count);
+    layers.clear();
+    findDuplicates(coordinates, real(0), duplicates, duplicateBuffers, nullptr);
+    if (count == 0)
+        return;
+    const std::vector<Index> &unique = duplicates.unique;
+    size_t origin = size_t(unique[lowestPoint(coordinates, unique.data(), unique.size())]);
+    peelConvexLayers(coordinates, unique.data(), unique.size(), origin, true, layers, buffers, limits);
+}
+
+template <typename Coord, typename Index>
+void BasicConvexLayers<Coord, Index>::depths(std::vector<Index> &out) const
+{
+    out.assign(coordinates.size(), Index(layers.size()));
+    for (size_t layer_i = 0; layer_i < layers.size(); ++layer_i) {
+        for (Index point : layers[layer_i])
+            out[point] = Index(layer_i);
+    }
+    for (size_t point = 0; point < out.size(); ++point)
+        out[point] = out[duplicates.representative(point)];
+}
+
+template <typename Coord, typename Index>
+size_t markInteriorPoints(const BasicPointArray<Coord> &points, const Index *subset, size_t count,
+                          std::vector<uint8_t> &interior, ThreadPool *pool)
+{
+    interior.assign(points.size(), 0);
+    if (count == 0)
+        return 0;
+    auto point = [subset](size_t i) { return subset ? size_t(subset[i]) : i; };
+    size_t parts = pool ? std::min(size_t(pool->size()), count) : 1;
+
+    // Extremes minimizing a x + b y, counterclockwise from the lowest point: the directions of y,
+    // y - x, -x, -x - y, -y, x - y, x and x + y
+    const int directions[8][2] = {{0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}, {1, 0}, {1, 1}};
+    std::vector<size_t> extremes(8 * parts, 0);
+    runTasks(pool, parts, [&](size_t part, unsigned) {
+        size_t begin, end;
+        blockRange(count, parts, part, begin, end);
+        size_t *best = &extremes[8 * part];
+        real values[8];
+        for (size_t d = 0; d < 8; ++d) {
+            best[d] = begin;
+            values[d] = std::numeric_limits<real>::max();
+        }
+        for (size_t i = begin; i < end; ++i) {
+            real x = real(points.x[point(i)]), y = real(points.y[point(i)]);
+            for (size_t d = 0; d < 8; ++d) {
+                real value = directions[d][0] * x + directions[d][1] * y;
+                if (value < values[d]) {
+                    values[d] = value;
+                    best[d] = i;
+                }
+            }
+        }
+    });
+
+    // Octagon without repeated vertices. Its corners are input points, so whatever rounding did to
+    // the choice of the extremes, a point left of all its sides lies strictly inside the hull.
+    size_t octagon[8], corners = 0;
+    for (size_t d = 0; d < 8; ++d) {
+        size_t choice = extremes[d];
+        real best = directions[d][0] * real(points.x[point(choice)]) + directions[d][1] * real(points.y[point(choice)]);
+        for (size_t part = 1; part < parts; ++part) {
+            size_t other = extremes[8 * part + d];
+            real value = directions[d][0] * real(points.x[point(other)]) + directions[d][1] * real(points.y[point(other)]);
+            if (value < best) {
+                best = value;
+                choice = other;
+            }
+        }
+        size_t extreme = point(choice);
+        if (corners == 0 || (points.x[extreme] != points.x[octagon[corners - 1]] ||
+                             points.y[extreme] != points.y[octagon[corners - 1]]))
+            octagon[corners++] = extreme;
+    }
+    while (corners > 1 && points.x[octagon[corners - 1]] == points.x[octagon[0]] &&
+           points.y[octagon[corners - 1]] == points.y[octagon[0]])
+        --corners;
+
+    // Box between the inner coordinates of the corners on each side. If the octagon holds all of its
+    // corners, points strictly inside it are strictly inside the octagon, which two comparisons
+    // per axis decide for most of them.
+    auto corner = [&](size_t d, bool y) { return y ? real(points.y[octagon[d]]) : real(points.x[octagon[d]]); };
+    bool box = corners == 8;
+    real left = 0, right = 0, bottom = 0, top = 0;
+    if (box) {
+        left = std::max(std::max(corner(5, false), corner(6, false)), corner(7, false));
+        right = std::min(std::min(corner(1, false), corner(2, false)), corner(3, false));
+        bottom = std::max(std::max(corner(7, true), corner(0, true)), corner(1, true));
+        top = std::min(std::min(corner(3, true), corner(4, true)), corner(5, true));
+        const real box_x[4] = {left, right, right, left}, box_y[4] = {bottom, bottom, top, top};
+        for (size_t c = 0; c < corners && box; ++c) {
+            real x0 = real(points.x[octagon[c]]), y0 = real(points.y[octagon[c]]);
+            real x1 = real(points.x[octagon[(c + 1) % corners]]), y1 = real(points.y[octagon[(c + 1) % corners]]);
+            for (size_t k = 0; k < 4 && box; ++k)
+                box = orient2d(x0, y0, x1, y1, box_x[k], box_y[k]) >= 0;
+        }
+    }
+
+    std::vector<size_t> inside(parts, 0);
+    runTasks(pool, parts, [&](size_t part, unsigned) {
+        size_t begin, end;
+        blockRange(count, parts, part, begin, end);
+        size_t found = 0;
+        for (size_t i = begin; i < end; ++i) {
+            size_t p = point(i);
+            real x = real(points.x[p]), y = real(points.y[p]);
+            bool strictly = box && x > left && x < right && y > bottom && y < top;
+            if (!strictly) {
+                strictly = corners >= 3;
+                for (size_t c = 0; c < corners && strictly; ++c)
+                    strictly = get_side(points, octagon[c], octagon[(c + 1) % corners], p) > 0;
+            }
+            interior[p] = strictly;
+            found += strictly;
+        }
+        inside[part] = found;
+    });
+
+    size_t total = 0;
+    for (size_t part = 0; part < parts; ++part)
+        total += inside[part];
+    return total;
+}
+
+template class HullTree<int>;
+template class HullTree<int64_t>;
+
+#define INSTANTIATE_PEEL(Coord, Index) \
+    template void peelConvexLayers(const BasicPointArray<Coord>&, const Index*, size_t, size_t, bool, LayerList<Index>&, \
+                                   PeelBuffers<Index>&, const PeelLimits&); \
+    template class BasicConvexLayers<Coord, Index>; \
+    template size_t markInteriorPoints(const BasicPointArray<Coord>&, const Index*, size_t, std::vector<uint8_t>&, \
+                                       ThreadPool*);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_PEEL)
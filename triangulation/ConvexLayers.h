@@ -0,0 +1,186 @@
+#ifndef CONVEXLAYERS_H
+#define CONVEXLAYERS_H
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "Duplicates.h"
+#include "LayerList.h"
+#include "PointArray.h"
+
+class ThreadPool;
+
+enum LayerEngine
+{
+    LAYERS_GRAHAM_SCAN, // Graham scan over all remaining points for every layer, O(n * layers)
+    LAYERS_HULL_TREE    // Deletion-only hull tree, O(n log^2 n) in total, for distinct points
+};
+
+// Upper hull of points sorted by (x, y) supporting deletions (Overmars - van Leeuwen).
+// Every internal node keeps the bridge of its subtree, so a deletion only recomputes
+// the bridges on the path to the root. With lower = true the point set is rotated by
+// 180 degrees and the tree maintains the lower hull, leaf i being point count - 1 - i.
+// Node is the signed integer type numbering the nodes, it must hold twice the point count.
+// A tree may be built again for other points, reusing its storage.
+template <typename Node>
+class HullTree
+{
+public:
+    HullTree() : count(0), size(1), lower(false) {}
+
+    void build(const real *xs, const real *ys, Node count, bool lower);
+
+    bool empty() const { return !alive(1); }
+
+    // Remove points given by their positions in the sorted order
+    void erase(const std::vector<Node> &positions);
+
+    // Append hull vertices as positions in the sorted order, clockwise
+    void hull(std::vector<Node> &out) const;
+
+    // Append the points on the side between the hull vertices from and to, consecutive in the
+    // order of hull(), without the vertices themselves, in the same order
+    void sidePoints(Node from, Node to, std::vector<Node> &out) const;
+
+private:
+    real x(Node leaf) const { return coords[2 * leaf]; }
+    real y(Node leaf) const { return coords[2 * leaf + 1]; }
+    Node position(Node leaf) const { return lower ? count - 1 - leaf : leaf; }
+
+    bool alive(Node node) const {
+        return node >= size ? leaves[node - size] != 0 : bridges[node].left >= 0;
+    }
+
+    bool isLeaf(Node node) const { return node >= size; }
+
+    // Skip nodes with a single nonempty child
+    Node canonical(Node node) const;
+    Node rightmost(Node node) const;
+    Node leftmost(Node node) const;
+
+    void update(Node node);
+    void bridge(Node node);
+
+    void report(Node node, Node from, Node to, std::vector<Node> &out) const;
+
+    // Leaf of the subtree farthest left of the direction (dx, dy)
+    Node extreme(Node node, real dx, real dy) const;
+
+    // Points of the subtree of node, holding the leaves [begin, end), between the leaves first
+    // and last and on the line through them
+    void sidePoints(Node node, Node begin, Node end, Node first, Node last, std::vector<Node> &out) const;
+
+    real orientation(Node l1, Node l2, Node l3) const;
+
+    Node count, size;
+    bool lower;
+
+    // Leaf coordinates, rotated for the lower hull
+    std::vector<real> coords;
+
+    // Bridge endpoints of every internal node as leaf numbers, -1 for empty subtrees
+    struct Bridge { Node left, right; };
+    std::vector<Bridge> bridges;
+    std::vector<uint8_t> leaves;
+
+    // Nodes to recompute by erase(), level by level
+    std::vector<Node> nodes, parents;
+};
+
+// Tree nodes are numbered up to four times the point count
+template <typename Index>
+using HullNode = typename std::conditional<std::is_signed<Index>::value && sizeof(Index) < 8, int, int64_t>::type;
+
+// Buffers of peelConvexLayers(), kept by the caller to reuse them
+template <typename Index>
+struct PeelBuffers
+{
+    std::vector<Index> subset, order;
+    std::vector<real> xs, ys;
+    std::vector<HullNode<Index> > chains, cycle;
+    HullTree<HullNode<Index> > upper, lower;
+};
+
+// Where a partial peel stops: after maxLayers layers, or before the first layer of fewer than
+// minLayerSize points
+struct PeelLimits
+{
+    PeelLimits() : maxLayers(SIZE_MAX), minLayerSize(0) {}
+
+    size_t maxLayers;
+    size_t minLayerSize;
+};
+
+// Peel the convex layers of the points subset[0..count) with a pair of hull trees and append them
+// to layers. Every layer is stored counterclockwise starting at the vertex with the least polar
+// angle around the origin, except for the outermost layer of the point set, which starts at the
+// origin itself. Points on the sides of a hull belong to its layer, so the layers are those of
+// the Graham scans. With outermost = false the subset is what remains inside other layers. The
+// points must be distinct: copies of a point are neither left nor right of each other, so the
+// trees would split them between layers.
+template <typename Coord, typename Index>
+void peelConvexLayers(const BasicPointArray<Coord> &points, const Index *subset, size_t count, size_t origin,
+                      bool outermost, LayerList<Index> &layers, PeelBuffers<Index> &buffers,
+                      const PeelLimits &limits = PeelLimits());
+
+// All layers of all points, origin being their lowest point
+template <typename Coord, typename Index>
+void peelConvexLayers(const BasicPointArray<Coord> &points, size_t origin, LayerList<Index> &layers,
+                      PeelBuffers<Index> &buffers, const PeelLimits &limits = PeelLimits())
+{
+    std::vector<Index> &all = buffers.subset;
+    all.resize(points.size());
+    for (size_t index = 0; index < all.size(); ++index)
+        all[index] = Index(index);
+    peelConvexLayers(points, all.data(), all.size(), origin, true, layers, buffers, limits);
+}
+
+// Akl-Toussaint filter: interior[p] = 1 for the points p of subset (all points for nullptr)
+// strictly inside the octagon of their extreme points along the axes and diagonals, which can
+// be neither vertices nor boundary points of their hull, 0 for all other points. One pass in
+// subset order, in blocks on the pool; returns the number of interior points.
+template <typename Coord, typename Index>
+size_t markInteriorPoints(const BasicPointArray<Coord> &points, const Index *subset, size_t count,
+                          std::vector<uint8_t> &interior, ThreadPool *pool);
+
+// Convex layers on their own, for jobs that need no triangulation: the outermost layers, or the
+// layer depth of every point. The hull tree engine peels only up to the limits, so asking for a
+// few outer layers costs little more than building the trees.
+template <typename Coord, typename Index>
+class BasicConvexLayers
+{
+public:
+    typedef BasicPointArray<Coord> Points;
+
+    // Peel the coordinate arrays in place, without copying them. The arrays must stay valid as
+    // long as depths() is used.
+    BasicConvexLayers(const Coord *x, const Coord *y, size_t count, const PeelLimits &limits = PeelLimits());
+
+    // Empty layers for peel() to fill
+    BasicConvexLayers() {}
+
+    // Peel another point set, reusing the layers and buffers of the previous one
+    void peel(const Coord *x, const Coord *y, size_t count, const PeelLimits &limits = PeelLimits());
+
+    // True unless a limit left points inside the last layer
+    bool complete() const { return layers.offsets().back() == duplicates.unique.size(); }
+
+    // Layer of every point, counted from the outermost one; points inside the last layer peeled
+    // get layers.size(). A point on a side of a layer belongs to it, so points on the boundary of
+    // the hull have depth 0, as in the layers of the Graham scans. Copies of a point get its depth.
+    void depths(std::vector<Index> &out) const;
+
+    // Convex layers, outermost first, counterclockwise. Of equal points only the first is peeled.
+    LayerList<Index> layers;
+
+private:
+    Points coordinates;
+    DuplicateMap<Index> duplicates;
+    DuplicateBuffers<Index> duplicateBuffers;
+    PeelBuffers<Index> buffers;
+};
+
+typedef BasicConvexLayers<real, int> ConvexLayers;
+
+#endif // CONVEXLAYERS_H
@@ -1,6 +1,19 @@
 #ifndef DEFS_H
 #define DEFS_H
 
+#include <cstdint>
+
+// Arithmetic type of the predicates and of all derived quantities. Coordinates may be stored as
+// float, double, int32_t or int64_t, every one of them converts to it exactly (int64_t values
+// as long as they stay within +-2^53).
 typedef double real;
 
+// Expand MACRO(Coord, Index) for every supported pair of coordinate and index type, used for
+// the explicit instantiations of the templates
+#define FOR_EACH_COORDINATE_AND_INDEX(MACRO) \
+    MACRO(float, int)   MACRO(float, uint32_t)   MACRO(float, uint64_t) \
+    MACRO(double, int)  MACRO(double, uint32_t)  MACRO(double, uint64_t) \
+    MACRO(int32_t, int) MACRO(int32_t, uint32_t) MACRO(int32_t, uint64_t) \
+    MACRO(int64_t, int) MACRO(int64_t, uint32_t) MACRO(int64_t, uint64_t)
+
 #endif // DEFS_H
@@ -0,0 +1,84 @@
+#ifndef DIAGONALRULES_H
+#define DIAGONALRULES_H
+
+#include <algorithm>
+
+#include "Defs.h"
+
+enum DiagonalRule
+{
+    DIAGONAL_MAX_MIN_ANGLE, // Maximize the smallest angle of the two triangles
+    DIAGONAL_MIN_MAX_ANGLE, // Minimize the largest angle of the two triangles
+    DIAGONAL_SHORTEST       // Take the shorter diagonal
+};
+
+// Quadrilateral of a strip step: the current spoke runs from the outer vertex p0 to the inner
+// vertex q0, p1 and q1 are the next vertices of the layers. The step either takes the diagonal
+// p0 - q1 (triangles p0 q0 q1 and p0 q1 p1) or p1 - q0 (triangles p0 p1 q0 and p1 q1 q0).
+// All sides are squared lengths, so the rules get by without roots and trigonometry.
+struct StripQuad
+{
+    real spoke0, spoke1;       // p0 - q0, p1 - q1
+    real outer, inner;         // p0 - p1, q0 - q1
+    real diagonal0, diagonal1; // p0 - q1, p1 - q0
+};
+
+// Squared cosine of the angle between the sides b and c of a triangle with squared sides a, b, c,
+// negative for an obtuse angle. A degenerate triangle counts as one with a zero angle.
+inline real signedCosine2(real a, real b, real c)
+{
+    real numerator = b + c - a, denominator = 4 * b * c;
+    if (denominator == 0)
+        return 1;
+    return (numerator < 0 ? -numerator : numerator) * numerator / denominator;
+}
+
+// The smallest angle lies opposite the shortest side and never exceeds 60 degrees, so its
+// squared cosine decreases as the angle grows
+inline real smallestAngleCosine2(real a, real b, real c)
+{
+    if (a <= b && a <= c)
+        return signedCosine2(a, b, c);
+    return b <= c ? signedCosine2(b, c, a) : signedCosine2(c, a, b);
+}
+
+// The largest angle lies opposite the longest side, its signed squared cosine decreases as it grows
+inline real largestAngleCosine2(real a, real b, real c)
+{
+    if (a >= b && a >= c)
+        return signedCosine2(a, b, c);
+    return b >= c ? signedCosine2(b, c, a) : signedCosine2(c, a, b);
+}
+
+// Every rule tells whether the step should take the diagonal p0 - q1, that is advance on the
+// inner layer. Ties go to the outer layer.
+struct MaxMinAngleRule
+{
+    static bool advanceInner(const StripQuad &q) {
+        real inner = std::max(smallestAngleCosine2(q.diagonal0, q.spoke0, q.inner),
+                              smallestAngleCosine2(q.outer, q.diagonal0, q.spoke1));
+        real outer = std::max(smallestAngleCosine2(q.diagonal1, q.spoke0, q.outer),
+                              smallestAngleCosine2(q.inner, q.spoke1, q.diagonal1));
+        return inner < outer;
+    }
+};
+
+struct MinMaxAngleRule
+{
+    static bool advanceInner(const StripQuad &q) {
+        real inner = std::min(largestAngleCosine2(q.diagonal0, q.spoke0, q.inner),
+                              largestAngleCosine2(q.outer, q.diagonal0, q.spoke1));
+        real outer = std::min(largestAngleCosine2(q.diagonal1, q.spoke0, q.outer),
+                              largestAngleCosine2(q.inner, q.spoke1, q.diagonal1));
+        return inner > outer;
+    }
+};
+
+struct ShortestDiagonalRule
+{
+    static bool advanceInner(const StripQuad &q) {
+        return q.diagonal0 < q.diagonal1;
+    }
+};
+
+#endif // DIAGONALRULES_H
@@ -0,0 +1,218 @@
+#include "Duplicates.h"
+#include "RadixSort.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+template <typename Coord, typename Index>
+void findDuplicates(const BasicPointArray<Coord> &points, real tolerance, DuplicateMap<Index> &map,
+                    DuplicateBuffers<Index> &buffers, ThreadPool *pool)
+{
+    size_t count = points.size();
+    map.unique.clear();
+    map.rank.resize(count);
+    if (count == 0)
+        return;
+
+    std::vector<real> &bounds = buffers.bounds;
+    boundingBox(points, bounds, pool);
+    size_t parts = blockCount(pool, count);
+
+    // Cell and position share one key. Cells twice as wide as tolerance keep rounding from putting
+    // close points more than one cell apart; they are made wider still when the grid would not
+    // fit the key otherwise, which only costs more comparisons.
+    real min_x = bounds[0], min_y = bounds[1];
+    real span = std::max(bounds[2] - min_x, bounds[3] - min_y);
+    unsigned index_bits = valueBits(count);
+    unsigned axis_bits = std::min(31u, (64 - index_bits) / 2);
+    uint64_t last_cell = (uint64_t(1) << axis_bits) - 1;
+    real cell = std::max(2 * tolerance, span / real(last_cell));
+    real scale = cell > 0 ? 1 / cell : 0;
+
+    auto cellOf = [&](real value, real min) {
+        return uint64_t(std::max(real(0), std::min(real(last_cell), (value - min) * scale)));
+    };
+
+    std::vector<uint64_t> &items = buffers.items;
+    items.resize(count);
+    forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint64_t cx = cellOf(real(points.x[i]), min_x), cy = cellOf(real(points.y[i]), min_y);
+            items[i] = (((cx << axis_bits) | cy) << index_bits) | i;
+        }
+    });
+
+    radixSort(items, buffers.scratch, buffers.counts, index_bits, 2 * axis_bits, pool);
+
+    uint64_t mask = index_bits < 64 ? (uint64_t(1) << index_bits) - 1 : ~uint64_t(0);
+    std::vector<Index> &order = buffers.order;
+    order.resize(count);
+    forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            order[i] = Index(items[i] & mask);
+    });
+
+    auto key = [&](size_t position) { return items[position] >> index_bits; };
+    auto same = [&](Index a, Index b) { return points.x[a] == points.x[b] && points.y[a] == points.y[b]; };
+    auto before = [&](Index a, Index b) {
+        if (points.x[a] != points.x[b])
+            return points.x[a] < points.x[b];
+        if (points.y[a] != points.y[b])
+            return points.y[a] < points.y[b];
+        return a < b;
+    };
+
+    // Every block takes the cells starting in it: sorts them by x, chains equal points and, with
+    // a tolerance, sweeps the cell itself and the cells right and above for close points
+    buffers.pairs.resize(parts);
+    forBlocks(pool, parts, count, [&](size_t part, size_t begin, size_t end) {
+        std::vector<std::pair<Index,Index> > &pairs = buffers.pairs[part];
+        pairs.clear();
+        while (begin > 0 && begin < end && key(begin) == key(begin - 1))
+            ++begin;
+        for (size_t first = begin; first < end;) {
+            size_t last = first + 1;
+            while (last < count && key(last) == key(first))
+                ++last;
+            std::sort(order.begin() + first, order.begin() + last, before);
+            first = last;
+        }
+    });
+    forBlocks(pool, parts, count, [&](size_t part, size_t begin, size_t end) {
+        std::vector<std::pair<Index,Index> > &pairs = buffers.pairs[part];
+        while (begin > 0 && begin < end && key(begin) == key(begin - 1))
+            ++begin;
+        size_t run_end = begin;
+        for (size_t k = begin; k < count && (k < end || k < run_end); ++k) {
+            if (k >= run_end) {
+                run_end = k + 1;
+                while (run_end < count && key(run_end) == key(k))
+                    ++run_end;
+            }
+            Index point = order[k];
+            if (k > 0 && key(k - 1) == key(k) && same(order[k - 1], point)) {
+                pairs.push_back(std::make_pair(order[k - 1], point));
+                continue;
+            }
+            if (!(tolerance > 0))
+                continue;
+
+            real x = real(points.x[point]), y = real(points.y[point]);
+            auto sweep = [&](size_t from, size_t to) {
+                for (size_t j = from; j < to && real(points.x[order[j]]) - x < tolerance; ++j) {
+                    Index other = order[j];
+                    if (!same(point, other) && std::fabs(real(points.y[other]) - y) < tolerance)
+                        pairs.push_back(std::make_pair(point, other));
+                }
+            };
+            sweep(k + 1, run_end);
+
+            // The cells are computed monotonically, so a neighbor can only hold close points if the
+            // cell of the coordinate moved by tolerance is that neighbor
+            uint64_t cx = key(k) >> axis_bits, cy = key(k) & last_cell;
+            bool right = cellOf(x + tolerance, min_x) > cx;
+            bool above = cellOf(y + tolerance, min_y) > cy, below = cellOf(y - tolerance, min_y) < cy;
+            const int steps[4][2] = {{0, 1}, {1, -1}, {1, 0}, {1, 1}};
+            for (const int *step : steps) {
+                if ((step[0] > 0 && !right) || (step[1] > 0 && !above) || (step[1] < 0 && !below))
+                    continue;
+                uint64_t neighbor = ((cx + step[0]) << axis_bits) | (cy + step[1]);
+                auto from = std::lower_bound(items.begin(), items.end(), neighbor << index_bits);
+                auto to = std::lower_bound(from, items.end(), (neighbor + 1) << index_bits);
+                auto start = std::partition_point(order.begin() + (from - items.begin()), order.begin() + (to - items.begin()),
+                                                  [&](Index other) { return real(points.x[other]) <= x - tolerance; });
+                sweep(start - order.begin(), to - items.begin());
+            }
+        }
+    });
+
+    // Union by the smaller index keeps every parent below its child, so one pass in input order
+    // resolves all points to the first point of their group
+    std::vector<Index> &parent = map.rank;
+    forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            parent[i] = Index(i);
+    });
+    auto root = [&](Index point) {
+        while (parent[point] != point) {
+            parent[point] = parent[parent[point]];
+            point = parent[point];
+        }
+        return point;
+    };
+    for (const std::vector<std::pair<Index,Index> > &pairs : buffers.pairs) {
+        for (const std::pair<Index,Index> &pair : pairs) {
+            Index a = root(pair.first), b = root(pair.second);
+            if (a < b)
+                parent[b] = a;
+            else if (b < a)
+                parent[a] = b;
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+        parent[i] = parent[parent[i]];
+
+    // Kept points counted per block, then listed and numbered; order takes their positions
+    std::vector<size_t> &starts = buffers.counts;
+    starts.assign(parts + 1, 0);
+    forBlocks(pool, parts, count, [&](size_t part, size_t begin, size_t end) {
+        size_t kept = 0;
+        for (size_t i = begin; i < end; ++i)
+            kept += parent[i] == Index(i);
+        starts[part + 1] = kept;
+    });
+    for (size_t part = 0; part < parts; ++part)
+        starts[part + 1] += starts[part];
+    map.unique.resize(starts[parts]);
+    forBlocks(pool, parts, count, [&](size_t part, size_t begin, size_t end) {
+        size_t position = starts[part];
+        for (size_t i = begin; i < end; ++i) {
+            if (parent[i] == Index(i)) {
+                order[i] = Index(position);
+                map.unique[position++] = Index(i);
+            }
+        }
+    });
+    forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            parent[i] = order[parent[i]];
+    });
+}
+
+template <typename Coord, typename Index>
+bool collinearPoints(const BasicPointArray<Coord> &points, const Index *subset, size_t count, ThreadPool *pool)
+{
+    if (count < 3)
+        return true;
+
+    auto point = [&](size_t i) { return subset ? size_t(subset[i]) : i; };
+    size_t first = point(0), second = count;
+    for (size_t i = 1; i < count && second == count; ++i) {
+        if (points.x[point(i)] != points.x[first] || points.y[point(i)] != points.y[first])
+            second = point(i);
+    }
+    if (second == count)
+        return true;
+
+    // Blocks stop early once any of them has found a point off the line
+    std::atomic<bool> bent(false);
+    real x0 = real(points.x[first]), y0 = real(points.y[first]);
+    real x1 = real(points.x[second]), y1 = real(points.y[second]);
+    forBlocks(pool, blockCount(pool, count), count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !bent.load(std::memory_order_relaxed); ++i) {
+            size_t p = point(i);
+            if (orient2d(x0, y0, x1, y1, real(points.x[p]), real(points.y[p])) != 0)
+                bent = true;
+        }
+    });
+    return !bent;
+}
+
+#define INSTANTIATE_DUPLICATES(Coord, Index) \
+    template void findDuplicates(const BasicPointArray<Coord>&, real, DuplicateMap<Index>&, \
+                                 DuplicateBuffers<Index>&, ThreadPool*); \
+    template bool collinearPoints(const BasicPointArray<Coord>&, const Index*, size_t, ThreadPool*);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_DUPLICATES)
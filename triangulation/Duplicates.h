@@ -0,0 +1,55 @@
+#ifndef DUPLICATES_H
+#define DUPLICATES_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "PointArray.h"
+
+class ThreadPool;
+
+// Points left after merging duplicates, and where every input point went
+template <typename Index>
+struct DuplicateMap
+{
+    // Kept points in input order, the first point of every group of duplicates
+    std::vector<Index> unique;
+
+    // Position in unique of the point standing for every input point
+    std::vector<Index> rank;
+
+    // Kept point standing for an input point, the point itself if it was kept
+    Index representative(size_t point) const { return unique[rank[point]]; }
+
+    void clear() {
+        unique.clear();
+        rank.clear();
+    }
+};
+
+// Buffers of findDuplicates(), kept by the caller to reuse them
+template <typename Index>
+struct DuplicateBuffers
+{
+    std::vector<uint64_t> items, scratch;
+    std::vector<size_t> counts;
+    std::vector<real> bounds;
+    std::vector<Index> order;
+    std::vector<std::vector<std::pair<Index,Index> > > pairs;
+};
+
+// Merge points whose coordinates differ by less than tolerance along both axes, the test of
+// equal() in Point2D.h; tolerance 0 merges equal points only. Points chained by such pairs form
+// one group. The points are bucketed by grid cells at least tolerance wide with a radix sort,
+// so only points of neighboring cells are compared.
+template <typename Coord, typename Index>
+void findDuplicates(const BasicPointArray<Coord> &points, real tolerance, DuplicateMap<Index> &map,
+                    DuplicateBuffers<Index> &buffers, ThreadPool *pool);
+
+// True if all points of subset (all points for nullptr) lie on one line, including sets of
+// fewer than three distinct points
+template <typename Coord, typename Index>
+bool collinearPoints(const BasicPointArray<Coord> &points, const Index *subset, size_t count, ThreadPool *pool);
+
+#endif // DUPLICATES_H
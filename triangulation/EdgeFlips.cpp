@@ -0,0 +1,161 @@
+#include "EdgeFlips.h"
+#include "Predicates.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// Rounds with fewer suspect half-edges than this run on the calling thread
+const size_t FLIP_PARALLEL_MIN_EDGES = 4096;
+
+// Queue blocks per worker, so that workers finishing early can take over the rest
+const size_t FLIP_BLOCKS_PER_WORKER = 8;
+
+inline size_t nextEdge(size_t edge) { return edge % 3 == 2 ? edge - 2 : edge + 1; }
+inline size_t prevEdge(size_t edge) { return edge % 3 == 0 ? edge + 2 : edge - 1; }
+
+// Locks of the triangles taking part in one flip, released when it goes out of scope.
+// Without a lock array (serial rounds) every triangle counts as locked.
+class TriangleLocks
+{
+public:
+    explicit TriangleLocks(std::atomic<uint8_t> *locks) : locks(locks), count(0) {}
+
+    ~TriangleLocks() {
+        for (size_t i = 0; i < count; ++i)
+            locks[held[i]].store(0, std::memory_order_release);
+    }
+
+    // False if another worker holds the triangle
+    bool lock(size_t triangle) {
+        if (!locks)
+            return true;
+        for (size_t i = 0; i < count; ++i) {
+            if (held[i] == triangle)
+                return true;
+        }
+        if (locks[triangle].exchange(1, std::memory_order_acquire))
+            return false;
+        held[count++] = triangle;
+        return true;
+    }
+
+private:
+    std::atomic<uint8_t> *locks;
+    size_t held[4];
+    size_t count;
+};
+
+// Flip half-edge a when the vertex across it lies inside the circumcircle of its triangle and queue
+// the outer edges of the new triangles. False if a triangle was held by another worker.
+template <typename Coord, typename Index>
+bool legalize(const BasicPointArray<Coord> &points, Index *triangles, Index *halfedges,
+              std::atomic<uint8_t> *locks, size_t a, std::vector<Index> &found, uint64_t &flips)
+{
+    const Index NONE = Index(-1);
+    TriangleLocks held(locks);
+    if (!held.lock(a / 3))
+        return false;
+    if (halfedges[a] == NONE)
+        return true;
+    size_t b = halfedges[a];
+    if (!held.lock(b / 3))
+        return false;
+
+    // Triangle (pr, pl, p0) holds a = pr -> pl, triangle (pl, pr, p1) holds b = pl -> pr
+    size_t al = nextEdge(a), ar = prevEdge(a), br = nextEdge(b), bl = prevEdge(b);
+    size_t p0 = triangles[ar], pr = triangles[a], pl = triangles[al], p1 = triangles[bl];
+    if (incircle(real(points.x[pr]), real(points.y[pr]), real(points.x[pl]), real(points.y[pl]),
+                 real(points.x[p0]), real(points.y[p0]), real(points.x[p1]), real(points.y[p1])) <= 0)
+        return true;
+
+    // The flip moves the outer edges bl and ar to a and b, so their twins change as well
+    Index outer_b = halfedges[bl], outer_a = halfedges[ar];
+    if ((outer_b != NONE && !held.lock(outer_b / 3)) || (outer_a != NONE && !held.lock(outer_a / 3)))
+        return false;
+
+    // Now (p1, pl, p0) and (p0, pr, p1) with the diagonal ar = p0 -> p1, bl = p1 -> p0
+    triangles[a] = Index(p1);
+    triangles[b] = Index(p0);
+    halfedges[a] = outer_b;
+    if (outer_b != NONE)
+        halfedges[outer_b] = Index(a);
+    halfedges[b] = outer_a;
+    if (outer_a != NONE)
+        halfedges[outer_a] = Index(b);
+    halfedges[ar] = Index(bl);
+    halfedges[bl] = Index(ar);
+
+    ++flips;
+    found.push_back(Index(a));
+    found.push_back(Index(al));
+    found.push_back(Index(b));
+    found.push_back(Index(br));
+    return true;
+}
+
+}
+
+template <typename Coord, typename Index>
+uint64_t flipToDelaunay(const BasicPointArray<Coord> &points, std::vector<Index> &triangles,
+                        std::vector<Index> &halfedges, ThreadPool *pool, FlipBuffers<Index> &buffers)
+{
+    const Index NONE = Index(-1);
+
+    // Every inner edge once to begin with
+    std::vector<Index> &queue = buffers.queue;
+    queue.clear();
+    for (size_t edge = 0; edge < halfedges.size(); ++edge) {
+        if (halfedges[edge] != NONE && size_t(halfedges[edge]) > edge)
+            queue.push_back(Index(edge));
+    }
+
+    unsigned workers = pool ? pool->size() : 1;
+    if (buffers.found.size() < workers)
+        buffers.found.resize(workers);
+    size_t triangle_count = triangles.size() / 3;
+    if (pool && buffers.lockCount < triangle_count) {
+        buffers.locks.reset(new std::atomic<uint8_t>[triangle_count]);
+        buffers.lockCount = triangle_count;
+        for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+            buffers.locks[triangle].store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t flips = 0;
+    bool stalled = false;
+    while (!queue.empty()) {
+        bool parallel = pool && !stalled && queue.size() >= FLIP_PARALLEL_MIN_EDGES;
+        size_t blocks = parallel ? FLIP_BLOCKS_PER_WORKER * workers : 1;
+        std::atomic<uint64_t> round_flips(0);
+
+        runTasks(parallel ? pool : nullptr, blocks, [&](size_t block, unsigned worker) {
+            size_t begin, end;
+            blockRange(queue.size(), blocks, block, begin, end);
+            std::vector<Index> &found = buffers.found[worker];
+            uint64_t local_flips = 0;
+            for (size_t i = begin; i < end; ++i) {
+                if (!legalize(points, triangles.data(), halfedges.data(), parallel ? buffers.locks.get() : nullptr,
+                              size_t(queue[i]), found, local_flips))
+                    found.push_back(queue[i]);
+            }
+            round_flips += local_flips;
+        });
+
+        // Edges found or put back by the workers make the next round. After a parallel round that
+        // only ran into locks the next one runs serially, where nothing is ever locked.
+        queue.clear();
+        for (unsigned worker = 0; worker < workers; ++worker) {
+            std::vector<Index> &found = buffers.found[worker];
+            queue.insert(queue.end(), found.begin(), found.end());
+            found.clear();
+        }
+        stalled = round_flips == 0;
+        flips += round_flips;
+    }
+    return flips;
+}
+
+#define INSTANTIATE_FLIPS(Coord, Index) \
+    template uint64_t flipToDelaunay(const BasicPointArray<Coord>&, std::vector<Index>&, std::vector<Index>&, \
+                                     ThreadPool*, FlipBuffers<Index>&);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_FLIPS)
@@ -0,0 +1,40 @@
+#ifndef EDGEFLIPS_H
+#define EDGEFLIPS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PointArray.h"
+
+class ThreadPool;
+
+// Buffers of flipToDelaunay(), kept by the caller to reuse them
+template <typename Index>
+struct FlipBuffers
+{
+    // Half-edges still to check, and those found by every worker for the next round
+    std::vector<Index> queue;
+    std::vector<std::vector<Index> > found;
+
+    // One lock per triangle for the parallel rounds, all released between runs
+    std::unique_ptr<std::atomic<uint8_t>[]> locks;
+    size_t lockCount;
+
+    FlipBuffers() : lockCount(0) {}
+};
+
+// Lawson flips on a counterclockwise triangle mesh (triangles and the opposite half-edge of every
+// half-edge, NONE on the hull, as in BasicTriangleMesh) until every edge is locally Delaunay.
+// Flips keep the triangle and half-edge numbering valid, only the vertices and the pairing change.
+// Suspect edges are checked in rounds: a round hands its queue out to the workers of pool, every
+// flip queues the four outer edges of its quadrilateral for the next round. A flip locks its two
+// triangles and the two neighbors whose half-edges it rewrites, an edge whose triangles are busy
+// is put back into the queue. Rounds too small to share out, and rounds after one in which every
+// worker only ran into locks, run on the calling thread. Returns the number of flips.
+template <typename Coord, typename Index>
+uint64_t flipToDelaunay(const BasicPointArray<Coord> &points, std::vector<Index> &triangles,
+                        std::vector<Index> &halfedges, ThreadPool *pool, FlipBuffers<Index> &buffers);
+
+#endif // EDGEFLIPS_H
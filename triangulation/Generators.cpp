@@ -0,0 +1,128 @@
+#include "Generators.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const char *DISTRIBUTION_NAMES[DISTRIBUTION_COUNT] = {
+    "uniform-square", "uniform-disk", "gaussian", "clustered", "circle", "integer-grid"
+};
+
+const size_t BLOCK_SIZE = size_t(1) << 16;
+const double PI = 3.14159265358979323846;
+
+// splitmix64, small and fully specified, so the points are the same on every platform
+struct Random
+{
+    uint64_t state;
+
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1) with 53 random bits
+    double uniform() { return double(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Standard normal pair by the Box-Muller transform
+    void normal(double &z0, double &z1) {
+        double u = 1.0 - uniform(), v = uniform();
+        double r = std::sqrt(-2.0 * std::log(u));
+        z0 = r * std::cos(2.0 * PI * v);
+        z1 = r * std::sin(2.0 * PI * v);
+    }
+};
+
+uint64_t blockSeed(uint64_t seed, size_t block)
+{
+    Random random(seed ^ (uint64_t(block) * 0xD1B54A32D192ED03ull));
+    return random.next();
+}
+
+}
+
+const char *distributionName(Distribution distribution)
+{
+    return distribution < DISTRIBUTION_COUNT ? DISTRIBUTION_NAMES[distribution] : "unknown";
+}
+
+bool parseDistribution(const std::string &name, Distribution &distribution)
+{
+    for (int i = 0; i < DISTRIBUTION_COUNT; ++i) {
+        if (name == DISTRIBUTION_NAMES[i]) {
+            distribution = Distribution(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void generatePoints(Distribution distribution, size_t count, uint64_t seed,
+                    RealArray &x, RealArray &y, ThreadPool *pool)
+{
+    x.resize(count);
+    y.resize(count);
+
+    // Cluster centers are shared by all blocks, about one cluster per 10000 points
+    std::vector<double> centers;
+    if (distribution == DIST_CLUSTERED) {
+        Random random(seed);
+        centers.resize(2 * std::max<size_t>(1, count / 10000));
+        for (double &center : centers)
+            center = random.uniform();
+    }
+    size_t grid_side = std::max<size_t>(1, size_t(std::ceil(std::sqrt(double(count)))));
+
+    size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    runTasks(pool, blocks, [&](size_t block, unsigned) {
+        Random random(blockSeed(seed, block));
+        size_t begin = block * BLOCK_SIZE, end = std::min(count, begin + BLOCK_SIZE);
+
+        for (size_t i = begin; i < end; ++i) {
+            double px = 0.0, py = 0.0;
+            switch (distribution) {
+            case DIST_UNIFORM_SQUARE:
+                px = random.uniform();
+                py = random.uniform();
+                break;
+            case DIST_UNIFORM_DISK: {
+                double r = std::sqrt(random.uniform()), angle = 2.0 * PI * random.uniform();
+                px = r * std::cos(angle);
+                py = r * std::sin(angle);
+                break;
+            }
+            case DIST_GAUSSIAN:
+                random.normal(px, py);
+                break;
+            case DIST_CLUSTERED: {
+                size_t cluster = size_t(random.next() % (centers.size() / 2));
+                random.normal(px, py);
+                px = centers[2 * cluster] + 0.01 * px;
+                py = centers[2 * cluster + 1] + 0.01 * py;
+                break;
+            }
+            case DIST_CIRCLE: {
+                double angle = 2.0 * PI * double(i) / double(count);
+                px = std::cos(angle);
+                py = std::sin(angle);
+                break;
+            }
+            case DIST_INTEGER_GRID:
+                px = double(i % grid_side);
+                py = double(i / grid_side);
+                break;
+            default:
+                break;
+            }
+            x[i] = px;
+            y[i] = py;
+        }
+    });
+}
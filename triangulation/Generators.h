@@ -0,0 +1,30 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <cstdint>
+#include <string>
+
+#include "PointArray.h"
+
+class ThreadPool;
+
+enum Distribution
+{
+    DIST_UNIFORM_SQUARE,    // Uniform in [0, 1]^2
+    DIST_UNIFORM_DISK,      // Uniform in the unit disk
+    DIST_GAUSSIAN,          // Standard normal in both coordinates
+    DIST_CLUSTERED,         // Narrow normal clusters around uniform centers
+    DIST_CIRCLE,            // Evenly spaced on the unit circle, a single convex layer
+    DIST_INTEGER_GRID,      // Row by row on the integer grid, heavily collinear
+    DISTRIBUTION_COUNT
+};
+
+const char *distributionName(Distribution distribution);
+bool parseDistribution(const std::string &name, Distribution &distribution);
+
+// Generate count points of the distribution. The result depends on the seed only, not on the
+// number of threads: points are produced in fixed blocks with a generator seeded per block.
+void generatePoints(Distribution distribution, size_t count, uint64_t seed,
+                    RealArray &x, RealArray &y, ThreadPool *pool = nullptr);
+
+#endif // GENERATORS_H
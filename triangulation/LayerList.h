@@ -0,0 +1,80 @@
+#ifndef LAYERLIST_H
+#define LAYERLIST_H
+
+#include <cstddef>
+#include <vector>
+
+// Convex layers stored back to back in one index buffer: layer l is indices()[offset(l)] ..
+// indices()[offset(l + 1) - 1]. Clearing keeps both buffers, so refilling the list with no more
+// vertices and layers than before does not allocate.
+template <typename Index>
+class LayerList
+{
+public:
+    // Read-only view of one layer, valid until the list changes
+    class Layer
+    {
+    public:
+        Layer(const Index *first, size_t count) : first(first), count(count) {}
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        const Index *data() const { return first; }
+        const Index *begin() const { return first; }
+        const Index *end() const { return first + count; }
+
+        const Index &operator[](size_t i) const { return first[i]; }
+        const Index &front() const { return first[0]; }
+        const Index &back() const { return first[count - 1]; }
+
+    private:
+        const Index *first;
+        size_t count;
+    };
+
+    LayerList() : starts(1, 0) {}
+
+    size_t size() const { return starts.size() - 1; }
+    bool empty() const { return starts.size() == 1; }
+
+    Layer operator[](size_t l) const { return Layer(values.data() + starts[l], starts[l + 1] - starts[l]); }
+    Layer front() const { return (*this)[0]; }
+    Layer back() const { return (*this)[size() - 1]; }
+
+    // All layer vertices, layer after layer
+    const std::vector<Index> &indices() const { return values; }
+
+    // size() + 1 positions in indices(), the last one is the total vertex count
+    const std::vector<size_t> &offsets() const { return starts; }
+    size_t offset(size_t l) const { return starts[l]; }
+
+    void swap(LayerList &other) {
+        values.swap(other.values);
+        starts.swap(other.starts);
+    }
+
+    void clear() {
+        values.clear();
+        starts.resize(1);
+    }
+
+    // Append a layer of count vertices and return them to be filled in
+    Index *addLayer(size_t count) {
+        values.resize(values.size() + count);
+        starts.push_back(values.size());
+        return values.data() + values.size() - count;
+    }
+
+    template <typename Iterator>
+    void addLayer(Iterator first, Iterator last) {
+        values.insert(values.end(), first, last);
+        starts.push_back(values.size());
+    }
+
+private:
+    std::vector<Index> values;
+    std::vector<size_t> starts;
+};
+
+#endif // LAYERLIST_H
@@ -1,66 +1,307 @@
 #include "LayerTriangulation.h"
+#include "EdgeFlips.h"
+#include "PointKernels.h"
+#include "ThreadPool.h"
 
+#include <atomic>
+#include <limits>
 #include <stack>
-#include <deque>
 #include <fstream>
 
-inline bool is_collinear(const Point2D &p1, const Point2D &p2, const Point2D &p3) {
-    return equal(crossProduct((p1 - p2), (p3 - p2)), 0.0);
+template <typename Coord>
+inline real squaredDistance(const BasicPointArray<Coord> &points, size_t i, size_t j) {
+    real dx = real(points.x[j]) - real(points.x[i]), dy = real(points.y[j]) - real(points.y[i]);
+    return dx * dx + dy * dy;
 }
 
-inline real get_side(const Point2D &point1, const Point2D &point2, const Point2D &point3)
+// True if the point lies strictly inside the counterclockwise convex polygon
+template <typename Coord, typename Layer>
+bool strictlyInside(const BasicPointArray<Coord> &points, const Layer &polygon, size_t point)
 {
-    return crossProduct(point2 - point1, point3 - point1);
+    size_t size = polygon.size();
+    if (size < 3)
+        return false;
+    size_t first = polygon[0];
+    if (get_side(points, first, polygon[1], point) <= 0 || get_side(points, first, polygon[size - 1], point) >= 0)
+        return false;
+
+    // Wedge of the fan around the first vertex that holds the point
+    size_t low = 1, high = size - 1;
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (get_side(points, first, polygon[middle], point) > 0)
+            low = middle;
+        else
+            high = middle;
+    }
+    return get_side(points, polygon[low], polygon[high], point) > 0;
 }
 
-inline bool is_ccw(const Point2D &origin, const Point2D &point1, const Point2D &point2) {
-    return get_side(origin, point1, point2) >= 0;
+// First spoke of every strip between two layers and the end of the last one. A strip has one
+// spoke for every vertex of its two layers, a single inner point adds none. Returns the strip count.
+template <typename Index>
+size_t findStripOffsets(const LayerList<Index> &layers, std::vector<size_t> &offsets)
+{
+    size_t strip_count = layers.size() > 0 ? layers.size() - 1 : 0;
+    offsets.assign(strip_count + 1, 0);
+    for (size_t strip_i = 0; strip_i < strip_count; ++strip_i) {
+        size_t inner_size = layers[strip_i + 1].size();
+        offsets[strip_i + 1] = offsets[strip_i] + layers[strip_i].size() + (inner_size > 1 ? inner_size : 0);
+    }
+    return strip_count;
 }
 
-inline real calc_angle(const Point2D &origin, const Point2D &point1, const Point2D &point2) {
-    Point2D d1 = point1 - origin, d2 = point2 - origin;
-    return acos(dotProduct(d1, d2) / (d1.norm() * d2.norm()));
+// Spokes of the fan triangulating the last layer, which follow the strips in the edges
+template <typename Index>
+size_t fanEdgeCount(const LayerList<Index> &layers)
+{
+    size_t last_size = layers.size() > 0 ? layers.back().size() : 0;
+    return last_size > 3 ? last_size - 1 : 0;
 }
 
-inline real min_angle(const Point2D &point1, const Point2D &point2, const Point2D &point3) {
-    real angle0 = calc_angle(point1, point2, point3), angle1 = calc_angle(point2, point3, point1), angle2 = calc_angle(point3, point1, point2);
-    return std::min(angle0, std::min(angle1, angle2));
+// Every side of the layers [first, last) once
+template <typename Index>
+void appendSides(const LayerList<Index> &layers, size_t first, size_t last, std::vector<std::pair<Index,Index> > &out)
+{
+    for (size_t layer_i = first; layer_i < last; ++layer_i) {
+        typename LayerList<Index>::Layer layer = layers[layer_i];
+        size_t sides = layer.size() >= 3 ? layer.size() : layer.size() - (layer.size() > 0);
+        for (size_t i = 0; i < sides; ++i)
+            out.push_back(std::make_pair(layer[i], layer[(i + 1) % layer.size()]));
+    }
 }
 
-void print(const std::vector<int> &indices, const std::vector<Point2D> &points) {
-    std::for_each(indices.begin(), indices.end(), [&points](int i) { std::cout << "--" << points[i] << " "; });
+template <typename Layer>
+void print(const Layer &indices, const std::vector<Point2D> &points) {
+    std::for_each(indices.begin(), indices.end(), [&points](size_t i) { std::cout << "--" << points[i] << " "; });
     std::cout << std::endl;
 }
 
-LayerTriangulation::LayerTriangulation(const std::vector<Point2D> &points)
+// Inputs below this size are not worth starting worker threads for
+const size_t PARALLEL_MIN_POINTS = size_t(1) << 16;
+
+// Below this size the octagon filter does not pay for its pass over the points
+const size_t INTERIOR_FILTER_MIN_POINTS = size_t(1) << 12;
+
+// Layers peeled again at least after a change of the points, besides the changed ones
+const size_t REPAIR_MIN_LAYERS = 4;
+
+TriangulationOptions::TriangulationOptions() :
+    layerEngine(LAYERS_GRAHAM_SCAN), angularSort(SORT_PSEUDO_ANGLE), threads(0), topology(MESH_TRIANGLES),
+    diagonalRule(DIAGONAL_MAX_MIN_ANGLE), delaunayFlips(false), locationIndex(false),
+    removeDuplicates(false), duplicateTolerance(POINT_EPSILON), pool(nullptr)
 {
+}
 
-    std::vector<int> indices(points.size(), 0);
-    // Set up indices
-    for (int index = 0; index < indices.size(); ++index) {
-        indices[index] = index;
+template <typename Coord, typename Index>
+BasicLayerTriangulation<Coord, Index>::BasicLayerTriangulation(const std::vector<Point2D> &points, const TriangulationOptions &options) :
+    options(options), pool(nullptr), workspace(&ownWorkspace), flipped(false)
+{
+    coordinates.assign(points);
+    build();
+}
+
+template <typename Coord, typename Index>
+BasicLayerTriangulation<Coord, Index>::BasicLayerTriangulation(const Coord *x, const Coord *y, size_t count, const TriangulationOptions &options) :
+    options(options), pool(nullptr), workspace(&ownWorkspace), flipped(false)
+{
+    coordinates.view(x, y, count);
+    build();
+}
+
+template <typename Coord, typename Index>
+BasicLayerTriangulation<Coord, Index>::BasicLayerTriangulation(const TriangulationOptions &options) :
+    options(options), pool(nullptr), workspace(&ownWorkspace), flipped(false)
+{
+}
+
+template <typename Coord, typename Index>
+BasicLayerTriangulation<Coord, Index>::~BasicLayerTriangulation()
+{
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::triangulate(const Coord *x, const Coord *y, size_t count)
+{
+    coordinates.view(x, y, count);
+    build();
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::setWorkspace(TriangulationWorkspace<Index> *shared)
+{
+    workspace = shared ? shared : &ownWorkspace;
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::releaseWorkspace()
+{
+    ownWorkspace = TriangulationWorkspace<Index>();
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::build()
+{
+    layers.clear();
+    lowest.clear();
+    edges.clear();
+    mesh.clear();
+    location.clear();
+    duplicates.clear();
+    stats.clear();
+    flipped = false;
+    erased.clear();
+
+#ifndef TRIANGULATION_NO_STATS
+    stats.points = coordinates.size();
+#endif
+    if (coordinates.size() == 0)
+        return;
+
+    PhaseTimer total_timer(stats.totalTime);
+    uint64_t tests = orientationTestCount();
+
+    pool = options.pool;
+    if (!pool && options.threads != 1 && coordinates.size() >= PARALLEL_MIN_POINTS) {
+        if (!ownPool)
+            ownPool.reset(new ThreadPool(options.threads));
+        pool = ownPool.get();
     }
 
-    int origin_i = selectOrigin(points);
-    std::swap(indices[0], indices[origin_i]);
+    // Duplicates are left out like erased points, only the first point of every group is peeled.
+    // The hull tree engine needs distinct points, so it merges equal ones at least.
+    const Index *subset = nullptr;
+    size_t subset_size = coordinates.size();
+    bool collinear;
+    {
+        PhaseTimer timer(stats.duplicateTime);
+        if (options.removeDuplicates || options.layerEngine == LAYERS_HULL_TREE) {
+            real tolerance = options.removeDuplicates ? options.duplicateTolerance : real(0);
+            findDuplicates(coordinates, tolerance, duplicates, workspace->duplicates, pool);
+            if (duplicates.unique.size() < coordinates.size()) {
+                subset = duplicates.unique.data();
+                subset_size = duplicates.unique.size();
+                erased.assign(coordinates.size(), true);
+                for (Index point : duplicates.unique)
+                    erased[point] = false;
+            }
+#ifndef TRIANGULATION_NO_STATS
+            stats.duplicates = coordinates.size() - subset_size;
+#endif
+        }
+        collinear = subset_size >= 3 && collinearPoints(coordinates, subset, subset_size, pool);
+    }
+    if (collinear) {
+        connectCollinear(subset, subset_size);
+#ifndef TRIANGULATION_NO_STATS
+        stats.layerCount = layers.size();
+        stats.addLayer(layers[0].size());
+        stats.peakMemory = peakMemoryUsage();
+#endif
+        return;
+    }
 
-    // Select the origin
-    Point2D origin = points[indices[0]];
+    size_t origin_i;
+    {
+        PhaseTimer timer(stats.originTime);
+        origin_i = subset ? size_t(subset[lowestPoint(coordinates, subset, subset_size)]) : selectOrigin(coordinates);
+    }
 
-    // Calculate points in translated coordinate system
-    std::vector<Point2D> translated(points.size(), Point2D());
-    std::transform(points.begin(), points.end(), translated.begin(), [&origin](const Point2D &point) {
-        return point - origin;
-    });
+    // Extract layers
+    {
+        PhaseTimer timer(stats.layersTime);
+        if (options.layerEngine == LAYERS_HULL_TREE && subset)
+            peelConvexLayers(coordinates, subset, subset_size, origin_i, true, layers, workspace->peel);
+        else if (options.layerEngine == LAYERS_HULL_TREE)
+            peelConvexLayers(coordinates, origin_i, layers, workspace->peel);
+        else
+            extractLayers(origin_i, coordinates, subset, subset_size);
+    }
+    stats.orientationTests += orientationTestCount() - tests;
+
+#ifndef TRIANGULATION_NO_STATS
+    stats.layerCount = layers.size();
+    for (size_t layer_i = 0; layer_i < layers.size(); ++layer_i)
+        stats.addLayer(layers[layer_i].size());
+#endif
+
+    // Perform triangulation
+    triangulateLayers(coordinates);
+
+    // Triangulate the last layer if it is possible
+    {
+        PhaseTimer timer(stats.lastLayerTime);
+        traingluateLastLayer(coordinates);
+    }
+
+    if (options.delaunayFlips) {
+        PhaseTimer timer(stats.flipTime);
+        flipEdges(coordinates);
+    }
+
+    if (options.locationIndex && !mesh.neighbors.empty()) {
+        PhaseTimer timer(stats.meshTime);
+        buildLocationIndex(coordinates, layers, mesh, location, pool);
+    }
+
+#ifndef TRIANGULATION_NO_STATS
+    stats.peakMemory = peakMemoryUsage();
+#endif
+}
+
+template <typename Coord, typename Index>
+size_t BasicLayerTriangulation<Coord, Index>::selectOrigin(const Points &points)
+{
+    return lowestPoint(points, (const Index*)nullptr, points.size());
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::sortAngular(std::vector<Index> &indices, const Points &points, size_t origin_i)
+{
+    if (options.angularSort == SORT_PSEUDO_ANGLE) {
+        pseudoAngleSort(indices, 1, points, origin_i, pool, workspace->sort);
+        return;
+    }
+
+    atan2Sort(indices, 1, points, origin_i, workspace->sort);
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::extractLayers(size_t origin_i, const Points &points,
+                                                          const Index *subset, size_t count)
+{
+    std::vector<Index> &indices = workspace->indices;
+    indices.resize(count);
+    // Set up indices
+    for (size_t index = 0; index < indices.size(); ++index) {
+        indices[index] = subset ? subset[index] : Index(index);
+    }
+
+    if (subset)
+        std::swap(indices[0], *std::find(indices.begin(), indices.end(), Index(origin_i)));
+    else
+        std::swap(indices[0], indices[origin_i]);
+
+    // Akl-Toussaint filter for the outermost layer, run in input order before the sort scatters
+    // the points
+    std::vector<uint8_t> &interior = workspace->interior;
+    if (count < INTERIOR_FILTER_MIN_POINTS || markInteriorPoints(points, subset, count, interior, pool) == 0)
+        interior.clear();
 
     // Sort points counterclockwise
-    std::sort(indices.begin() + 1, indices.end(), [&translated](int i1, int i2) {
-        double angle0 = atan2(translated[i1].y, translated[i1].x), angle1 = atan2(translated[i2].y, translated[i2].x);
-        return angle0 < angle1 || (equal(angle0, angle1) && translated[i1].norm() < translated[i2].norm());
-    });
+    {
+        PhaseTimer timer(stats.sortTime);
+        sortAngular(indices, points, origin_i);
+    }
 
-    // Extract layers
-    std::vector<int> inner;
+    // The scan walks the last ray back into the origin, so its points must come farthest first
+    // to stay on the outermost layer
+    size_t closing = indices.size() - 1;
+    while (closing > 2 && get_side(points, indices[0], indices[closing - 1], indices.back()) == 0)
+        --closing;
+    std::reverse(indices.begin() + closing, indices.end());
+
+    std::vector<Index> &inner = workspace->inner;
     do {
         inner.clear(); // Clear inner indices vector
         // Perform Graham scan
@@ -73,119 +314,123 @@ LayerTriangulation::LayerTriangulation(const std::vector<Point2D> &points)
         // Debug print
         //print(layers.back(), points);
 
-        indices.resize(inner.size());
-        std::copy(inner.begin(), inner.end(), indices.begin());
+        // The inner points are the input of the next scan, the buffers swap roles
+        indices.swap(inner);
 
     } while (indices.size() > 1);
-
-    // Find the lowest point for each layer
-    for (int layer_i = 0; layer_i < layers.size(); ++layer_i) {
-        findLowestPoints(layer_i, points);
-    }
-
-    // Perform triangulation
-    for (int layer_i = 1; layer_i < layers.size(); ++layer_i) {
-        std::cout << layers[layer_i].size() << std::endl;
-        triangulate1(layer_i - 1, layer_i, points);
-    }
-
-    // Triangulate the last layer if it is possible
-    traingluateLastLayer(points);
-
 }
 
-int LayerTriangulation::selectOrigin(const std::vector<Point2D> &points)
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::connectCollinear(const Index *subset, size_t count)
 {
-    int index = 0;
-    for (int i = 1; i < points.size(); ++i) {
-        if (Point2D::yx_compare(points[i], points[index])) {
-            index = i;
-        }
-    }
-    return index;
+    std::vector<Index> &indices = workspace->indices;
+    indices.resize(count);
+    for (size_t index = 0; index < count; ++index)
+        indices[index] = subset ? subset[index] : Index(index);
+
+    // Along any line the lexicographic order of the points is their order on it
+    const Points &points = coordinates;
+    std::sort(indices.begin(), indices.end(), [&points](Index a, Index b) {
+        if (points.x[a] != points.x[b])
+            return points.x[a] < points.x[b];
+        if (points.y[a] != points.y[b])
+            return points.y[a] < points.y[b];
+        return a < b;
+    });
+
+    Index *layer = layers.addLayer(2);
+    layer[0] = indices.front();
+    layer[1] = indices.back();
+    lowest.assign(1, Index(lowestPoint(coordinates, layer, 2)));
+
+    edges.resize(count - 1);
+    for (size_t index = 1; index < count; ++index)
+        edges[index - 1] = std::make_pair(indices[index - 1], indices[index]);
+    flipped = true;
 }
 
-void LayerTriangulation::grahamScan0(const std::vector<int> &indices, const std::vector<Point2D> &points, std::vector<int> &inner)
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::grahamScan0(const std::vector<Index> &indices, const Points &points, std::vector<Index> &inner)
 {
     if (indices.size() == 0)
         return;
 
-    layers.push_back(std::vector<int>());
-    std::vector<int> &layer = layers.back();
-
-    if (indices.size() < 3) {
-        for (int index : indices)
-            layer.push_back(index);
-    } else if (indices.size() == 3) {
-        layer.push_back(indices[0]);
-        layer.push_back(indices[1]);
-        layer.push_back(indices[2]);
+    if (indices.size() <= 3) {
+        layers.addLayer(indices.begin(), indices.end());
     } else {
 
-        std::vector<bool> mask(indices.size(), false);
-        layer.reserve(indices.size());
+        std::vector<size_t> &hull = workspace->hull;
+        std::vector<bool> &mask = workspace->mask;
+        hull.clear();
+        mask.assign(indices.size(), false);
+
+        // Points extractLayers() found inside the octagon skip the scan and go straight to the inner
+        // ones, keeping their angular order
+        const std::vector<uint8_t> &interior = workspace->interior;
+        bool filtered = !interior.empty();
 
-        layer.push_back(0);
-        layer.push_back(1);
-        layer.push_back(2);
+        hull.push_back(0);
+        hull.push_back(1);
+        hull.push_back(2);
 
         for (size_t index = 3; index < indices.size(); ++index) {
-            int prev_index = layer.back(); layer.pop_back();
-            while (!is_ccw(points[indices[layer.back()]], points[indices[prev_index]], points[indices[index]])) {
+            if (filtered && interior[indices[index]])
+                continue;
+            size_t prev_index = hull.back(); hull.pop_back();
+            while (!is_ccw(points, indices[hull.back()], indices[prev_index], indices[index])) {
                 mask[prev_index] = true;
-                prev_index = layer.back();
-                layer.pop_back();
+                prev_index = hull.back();
+                hull.pop_back();
             }
-            layer.push_back(prev_index);
-            layer.push_back(index);
+            hull.push_back(prev_index);
+            hull.push_back(index);
         }
 
-        for (size_t index = 0; index < layer.size(); ++index) {
-            layer[index] = indices[layer[index]];
+        Index *layer = layers.addLayer(hull.size());
+        for (size_t index = 0; index < hull.size(); ++index) {
+            layer[index] = indices[hull[index]];
         }
 
         inner.push_back(indices[0]);
         for (size_t index = 0; index < mask.size();  ++index) {
-            if (mask[index])
+            if (mask[index] || (filtered && interior[indices[index]]))
                 inner.push_back(indices[index]);
         }
     }
 }
 
-void LayerTriangulation::grahamScan1(const std::vector<int> &indices, const std::vector<Point2D> &points, std::vector<int> &inner)
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::grahamScan1(const std::vector<Index> &indices, const Points &points, std::vector<Index> &inner)
 {
     if (indices.size() <= 1)
         return;
 
-    layers.push_back(std::vector<int>());
-    std::vector<int> &layer = layers.back();
-
     if (indices.size() < 4) {
-        for (size_t index = 1; index < indices.size(); ++index) {
-            layer.push_back(indices[index]);
-        }
+        layers.addLayer(indices.begin() + 1, indices.end());
     } else if (indices.size() == 4) {
-        if (is_ccw(points[indices[1]], points[indices[2]], points[indices[3]])) {
-            layer.push_back(indices[1]);
-            layer.push_back(indices[2]);
-            layer.push_back(indices[3]);
+        Index *layer = layers.addLayer(3);
+        layer[0] = indices[1];
+        if (is_ccw(points, indices[1], indices[2], indices[3])) {
+            layer[1] = indices[2];
+            layer[2] = indices[3];
         } else {
-            layer.push_back(indices[1]);
-            layer.push_back(indices[3]);
-            layer.push_back(indices[2]);
+            layer[1] = indices[3];
+            layer[2] = indices[2];
         }
     } else {
 
-        std::deque<int> hull;
-        std::vector<bool> mask(indices.size(), false);
+        std::vector<size_t> &hull = workspace->hull;
+        std::vector<bool> &mask = workspace->mask;
+        hull.clear();
+        mask.assign(indices.size(), false);
 
         hull.push_back(0);
         hull.push_back(1);
         hull.push_back(2);
 
         for (size_t index = 3; index < indices.size(); ++index) {
-            int prev_index = hull.back(); hull.pop_back();
-            while (!is_ccw(points[indices[hull.back()]], points[indices[prev_index]], points[indices[index]])) {
+            size_t prev_index = hull.back(); hull.pop_back();
+            while (!is_ccw(points, indices[hull.back()], indices[prev_index], indices[index])) {
                 mask[prev_index] = true;
                 prev_index = hull.back();
                 hull.pop_back();
@@ -195,12 +440,12 @@ void LayerTriangulation::grahamScan1(const std::vector<int> &indices, const std:
         }
 
         mask[1] = true;
-        hull.pop_front();
+        hull.erase(hull.begin());
 
-        for (int index = (int)indices.size() - 1; index > 0; --index) {
+        for (size_t index = indices.size() - 1; index > 0; --index) {
             if (mask[index]) {
-                int prev_index = hull.back(); hull.pop_back();
-                while (!is_ccw(points[indices[hull.back()]], points[indices[prev_index]], points[indices[index]])) {
+                size_t prev_index = hull.back(); hull.pop_back();
+                while (!is_ccw(points, indices[hull.back()], indices[prev_index], indices[index])) {
                     mask[prev_index] = true;
                     prev_index = hull.back();
                     hull.pop_back();
@@ -217,8 +462,9 @@ void LayerTriangulation::grahamScan1(const std::vector<int> &indices, const std:
         mask[1] = false;
         hull.pop_back();
 
-        for (auto it = hull.begin(); it != hull.end(); ++it) {
-            layer.push_back(indices[*it]);
+        Index *layer = layers.addLayer(hull.size());
+        for (size_t index = 0; index < hull.size(); ++index) {
+            layer[index] = indices[hull[index]];
         }
 
         inner.push_back(indices[0]);
@@ -229,20 +475,69 @@ void LayerTriangulation::grahamScan1(const std::vector<int> &indices, const std:
     }
 }
 
-void LayerTriangulation::findLowestPoints(int layer_i, const std::vector<Point2D> &points)
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::triangulateLayers(const Points &points)
 {
-    int lowest_i = 0;
+    // Find the lowest point for each layer
+    lowest.resize(layers.size());
 
-    for (size_t i = 1; i < layers[layer_i].size(); ++i) {
-        if (Point2D::yx_compare(points[layers[layer_i][i]], points[layers[layer_i][lowest_i]])) {
-            lowest_i = i;
-        }
+    // Strip sizes are known in advance, so every strip writes straight into its own range of the edges.
+    // The fan of the last layer follows them, so the buffer is allocated once at its final size.
+    std::vector<size_t> &offsets = workspace->stripOffsets;
+    size_t strip_count = findStripOffsets(layers, offsets);
+    edges.reserve(offsets.back() + fanEdgeCount(layers));
+    edges.resize(offsets.back());
+
+    auto findLowest = [&](size_t layer_i, unsigned) {
+        findLowestPoints(layer_i, points);
+    };
+
+    std::atomic<uint64_t> tests(0);
+    auto stitch = [&](size_t strip_i, unsigned) {
+        uint64_t before = orientationTestCount();
+        stitchStrip(strip_i, points, edges.data() + offsets[strip_i]);
+        tests += orientationTestCount() - before;
+    };
+
+    {
+        PhaseTimer timer(stats.lowestTime);
+        runTasks(pool, layers.size(), findLowest);
     }
-    lowest.push_back(lowest_i);
+    {
+        PhaseTimer timer(stats.stitchTime);
+        runTasks(pool, strip_count, stitch);
+    }
+    stats.orientationTests += tests;
+
+    PhaseTimer timer(stats.meshTime);
+    buildMesh(strip_count, points.size());
+}
 
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::stitchStrip(size_t strip_i, const Points &points, std::pair<Index,Index> *out)
+{
+    switch (options.diagonalRule) {
+    case DIAGONAL_MAX_MIN_ANGLE:
+        triangulate1<MaxMinAngleRule>(strip_i, strip_i + 1, points, out);
+        break;
+    case DIAGONAL_MIN_MAX_ANGLE:
+        triangulate1<MinMaxAngleRule>(strip_i, strip_i + 1, points, out);
+        break;
+    case DIAGONAL_SHORTEST:
+        triangulate1<ShortestDiagonalRule>(strip_i, strip_i + 1, points, out);
+        break;
+    }
 }
 
-bool LayerTriangulation::saveLaTeX(const std::string &filename, std::vector<Point2D> &points)
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::findLowestPoints(size_t layer_i, const Points &points)
+{
+    Layer layer = layers[layer_i];
+    lowest[layer_i] = Index(lowestPoint(points, layer.data(), layer.size()));
+}
+
+template <typename Coord, typename Index>
+bool BasicLayerTriangulation<Coord, Index>::saveLaTeX(const std::string &filename, std::vector<Point2D> &points)
 {
     std::ofstream out(filename);
     if (!out)
@@ -280,78 +575,177 @@ bool LayerTriangulation::saveLaTeX(const std::string &filename, std::vector<Poin
     return true;
 }
 
-void LayerTriangulation::triangulate0(int layer0, int layer1, const std::vector<Point2D> &points)
+template <typename Coord, typename Index>
+bool BasicLayerTriangulation<Coord, Index>::saveMesh(const std::string &filename, MeshFormat format) const
 {
-    int point0 = lowest[layer0];
-    int point1 = lowest[layer1];
+    // The layer sides are among the edges once the triangulation has been flipped
+    return ::saveMesh(filename, format, coordinates, mesh, edges, flipped ? LayerList<Index>() : layers);
+}
 
-    std::vector<int> &idx0 = layers[layer0];
-    std::vector<int> &idx1 = layers[layer1];
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::orderMesh(MeshOrder order, BasicOrderedMesh<Coord, Index> &out) const
+{
+    const Index NONE = mesh.NONE;
+    MeshOrderBuffers<Index> &buffers = workspace->order;
+    size_t count = coordinates.size();
+    std::vector<Index> &vertex_order = out.vertexOrder, &rank = out.vertexRank;
+
+    rank.assign(count, NONE);
+    vertex_order.clear();
+    if (order == MESH_ORDER_HILBERT || order == MESH_ORDER_MORTON) {
+        curveOrder(coordinates, order, vertex_order, buffers, pool);
+    } else if (order == MESH_ORDER_LAYERS) {
+        // Points on no layer, which the Graham scan engine leaves out, follow in input order
+        const std::vector<Index> &layered = layers.indices();
+        vertex_order.assign(layered.begin(), layered.end());
+        for (Index point : layered)
+            rank[point] = 0;
+        for (size_t point = 0; point < count; ++point) {
+            if (rank[point] == NONE)
+                vertex_order.push_back(Index(point));
+        }
+    } else {
+        vertex_order.resize(count);
+        for (size_t point = 0; point < count; ++point)
+            vertex_order[point] = Index(point);
+    }
+    if (!erased.empty()) {
+        vertex_order.erase(std::remove_if(vertex_order.begin(), vertex_order.end(),
+                                          [this](Index point) { return erased[point]; }), vertex_order.end());
+    }
+
+    size_t vertex_count = vertex_order.size(), parts = pool ? pool->size() : 1;
+    out.x.resize(vertex_count);
+    out.y.resize(vertex_count);
+    runTasks(pool, parts, [&](size_t part, unsigned) {
+        size_t begin, end;
+        blockRange(vertex_count, parts, part, begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            Index point = vertex_order[i];
+            rank[point] = Index(i);
+            out.x[i] = coordinates.x[point];
+            out.y[i] = coordinates.y[point];
+        }
+    });
+
+    renumberTriangles(mesh, rank, vertex_count, out.mesh, out.triangleOrder, buffers, pool);
+
+    // The layer sides are among the edges once the triangulation has been flipped
+    out.edges.reserve(edges.size() + (flipped ? 0 : layerSideCount(layers)));
+    out.edges.assign(edges.begin(), edges.end());
+    if (!flipped) {
+        forEachLayerSide(layers, [&out](Index i1, Index i2) {
+            out.edges.push_back(std::make_pair(i1, i2));
+        });
+    }
+    renumberEdges(out.edges, rank, vertex_count, buffers, pool);
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::locate(const real *x, const real *y, size_t count, Index *triangles)
+{
+    if (!pool && options.threads != 1 && count >= PARALLEL_MIN_POINTS) {
+        if (!ownPool)
+            ownPool.reset(new ThreadPool(options.threads));
+        pool = ownPool.get();
+    }
+    if (location.empty() && !mesh.neighbors.empty())
+        buildLocationIndex(coordinates, layers, mesh, location, pool);
+
+    PointArray queries;
+    queries.view(x, y, count);
+    locatePoints(coordinates, layers, mesh, location, queries, triangles, workspace->queryOrder,
+                 workspace->order, pool);
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::triangulate0(size_t layer0, size_t layer1, const Points &points, EdgeList &out)
+{
+    const size_t end0 = size_t(lowest[layer0]), end1 = size_t(lowest[layer1]);
+    size_t point0 = end0;
+    size_t point1 = end1;
+
+    Layer idx0 = layers[layer0];
+    Layer idx1 = layers[layer1];
 
     do {
-        edges.push_back(std::make_pair(idx0[point0], idx1[point1]));
+        out.push_back(std::make_pair(idx0[point0], idx1[point1]));
 
-        if (!is_ccw(points[idx0[point0]], points[idx1[point1]], points[idx1[(point1 + 1) % idx1.size()]])) {
+        if (!is_ccw(points, idx0[point0], idx1[point1], idx1[(point1 + 1) % idx1.size()])) {
             point1 = (point1 + 1) % idx1.size();
         } else {
             point0 = (point0 + 1) % idx0.size();
         }
-    } while (point0 != lowest[layer0] || point1 != lowest[layer1]);
+    } while (point0 != end0 || point1 != end1);
 
 }
 
-void LayerTriangulation::triangulate1(int layer0, int layer1, const std::vector<Point2D> &points)
+template <typename Coord, typename Index>
+template <typename Rule>
+void BasicLayerTriangulation<Coord, Index>::triangulate1(size_t layer0, size_t layer1, const Points &points, std::pair<Index,Index> *out)
 {
 
-    std::vector<int> &idx0 = layers[layer0];
-    std::vector<int> &idx1 = layers[layer1];
-
-    int point0 = lowest[layer0], point1 = 0;
+    Layer idx0 = layers[layer0];
+    Layer idx1 = layers[layer1];
 
-    real min_dist = distance(points[idx0[point0]], points[idx1[point1]]);
-    for (int index = 1; index < idx1.size(); ++index) {
-        real dist = distance(points[idx0[point0]], points[idx1[index]]);
-        if (dist < min_dist) {
-            point1 = index;
-            min_dist = dist;
-        }
-    }
+    // The spoke between the lowest points of both layers starts the walk. Nothing of the inner
+    // layer lies below its lowest point, which is at least as high as the outer one, so the spoke
+    // cannot cross the inner layer and no search for a visible inner point is needed.
+    size_t point0 = lowest[layer0];
+    size_t point1 = lowest[layer1];
 
-    int end0 = point0, end1 = point1;
-    do {
+    // Every step adds one triangle, the walk goes around both layers exactly once. A single
+    // inner point has no edges to walk along.
+    size_t total0 = idx0.size(), total1 = idx1.size() > 1 ? idx1.size() : 0;
+    size_t steps0 = 0, steps1 = 0;
+    for (;;) {
 
-        edges.push_back(std::make_pair(idx0[point0], idx1[point1]));
+        *out++ = std::make_pair(idx0[point0], idx1[point1]);
 
-        int next0 = (point0 + 1) % idx0.size(), next1 = (point1 + 1) % idx1.size();
-        if ((point0 == end0 && next1 == end1 && idx1.size() > 1) || (point1 == end1 && next0 == end0))
+        // The last triangle closes on the first spoke
+        if (steps0 + steps1 + 1 == total0 + total1)
             break;
-        
-        if (!is_ccw(points[idx0[point0]], points[idx1[point1]], points[idx1[next1]])) {
+
+        size_t next0 = (point0 + 1) % idx0.size(), next1 = (point1 + 1) % idx1.size();
+
+        // A layer that has been walked around completely must wait for the other one
+        bool advance1;
+        if (steps0 == total0) {
+            advance1 = true;
+        } else if (steps1 == total1) {
+            advance1 = false;
+        } else if (!is_ccw(points, idx0[point0], idx1[point1], idx1[next1])) {
             // Check if we can build next triangle
-            if (!is_ccw(points[idx0[next0]], points[idx1[point1]], points[idx1[next1]])) {
-                // Check triangle with minimum angle
-                real angle0 = std::min(min_angle(points[idx0[point0]], points[idx1[point1]], points[idx1[next1]]),
-                              min_angle(points[idx0[point0]], points[idx1[next1]], points[idx0[next0]]));
-                real angle1 = std::min(min_angle(points[idx0[point0]], points[idx0[next0]], points[idx1[point1]]),
-                              min_angle(points[idx0[next0]], points[idx1[next1]], points[idx1[point1]]));
-                if (angle0 > angle1) {
-                    point1 = next1;
-                } else {
-                    point0 = next0;
-                }
+            if (!is_ccw(points, idx0[next0], idx1[point1], idx1[next1])) {
+                // Both diagonals are possible, the rule picks one
+                StripQuad quad;
+                quad.spoke0 = squaredDistance(points, idx0[point0], idx1[point1]);
+                quad.spoke1 = squaredDistance(points, idx0[next0], idx1[next1]);
+                quad.outer = squaredDistance(points, idx0[point0], idx0[next0]);
+                quad.inner = squaredDistance(points, idx1[point1], idx1[next1]);
+                quad.diagonal0 = squaredDistance(points, idx0[point0], idx1[next1]);
+                quad.diagonal1 = squaredDistance(points, idx0[next0], idx1[point1]);
+                advance1 = Rule::advanceInner(quad);
             } else {
-                point1 = next1;
+                advance1 = true;
             }
         } else {
-            point0 = next0;
+            advance1 = false;
         }
-    } while (point0 != end0 || point1 != end1);
+
+        if (advance1) {
+            point1 = next1; ++steps1;
+        } else {
+            point0 = next0; ++steps0;
+        }
+    }
 
 }
 
-void LayerTriangulation::traingluateLastLayer(const std::vector<Point2D> &points)
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::traingluateLastLayer(const Points &points)
 {
-    std::vector<int> &idx = layers.back();
+    Layer idx = layers.back();
 
     if (idx.size() > 3) {
         for (size_t index = 1; index < idx.size(); ++index) {
@@ -359,3 +753,466 @@ void LayerTriangulation::traingluateLastLayer(const std::vector<Point2D> &points
         }
     }
 }
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::buildMesh(size_t strip_count, size_t point_count)
+{
+    mesh.clear();
+    if ((options.topology == MESH_EDGES_ONLY && !options.delaunayFlips) || layers.empty())
+        return;
+
+    // Layer edge i of layer l runs from layers[l][i] to the next vertex, slots are numbered
+    // from the layer offsets
+    const std::vector<size_t> &layer_offsets = layers.offsets();
+
+    // One triangle per spoke in every strip, so the strips start at their spoke offsets, and the
+    // fan of the last layer comes after them
+    size_t last_size = layers.back().size();
+    std::vector<size_t> &offsets = workspace->stripOffsets;
+    offsets.push_back(offsets[strip_count] + (last_size >= 3 ? last_size - 2 : 0));
+
+    // A triangulation of n points with h of them on the hull has 2n - 2 - h triangles
+    size_t hull_size = layers[0].size();
+    if (2 * point_count > hull_size + 2)
+        mesh.triangles.reserve(3 * (2 * point_count - 2 - hull_size));
+    mesh.triangles.resize(3 * offsets.back());
+
+    // Half-edges lying on the layer edges, from the triangle inside the layer and from the one outside
+    const Index NONE = mesh.NONE;
+    std::vector<Index> &twins = workspace->twins, &inside = workspace->inside, &outside = workspace->outside;
+    twins.assign(mesh.triangles.size(), NONE);
+    inside.assign(layer_offsets.back(), NONE);
+    outside.assign(layer_offsets.back(), NONE);
+
+    auto link = [&twins](size_t edge0, size_t edge1) {
+        twins[edge0] = Index(edge1);
+        twins[edge1] = Index(edge0);
+    };
+
+    // Triangle j of a strip lies between spokes j and j + 1 and is stored as (u, w, v), where
+    // spoke j is (u, v) and w is the vertex the walk advanced to. Strips touch disjoint slots.
+    auto fillStrip = [&](size_t strip_i, unsigned) {
+        const std::pair<Index,Index> *spokes = edges.data() + offsets[strip_i];
+        size_t spoke_count = offsets[strip_i + 1] - offsets[strip_i];
+        Layer idx0 = layers[strip_i], idx1 = layers[strip_i + 1];
+        size_t slots0 = layer_offsets[strip_i], slots1 = layer_offsets[strip_i + 1];
+
+        size_t point0 = lowest[strip_i];
+        size_t point1 = lowest[strip_i + 1];
+
+        for (size_t j = 0; j < spoke_count; ++j) {
+            size_t t = offsets[strip_i] + j, next_t = offsets[strip_i] + (j + 1) % spoke_count;
+            const std::pair<Index,Index> &spoke = spokes[j], &next = spokes[(j + 1) % spoke_count];
+            bool advance0 = next.first != spoke.first;
+
+            mesh.triangles[3 * t] = spoke.first;
+            mesh.triangles[3 * t + 1] = advance0 ? next.first : next.second;
+            mesh.triangles[3 * t + 2] = spoke.second;
+
+            if (advance0) {
+                inside[slots0 + point0] = Index(3 * t);
+                link(3 * t + 1, 3 * next_t + 2);
+                point0 = (point0 + 1) % idx0.size();
+            } else {
+                outside[slots1 + point1] = Index(3 * t + 1);
+                link(3 * t, 3 * next_t + 2);
+                point1 = (point1 + 1) % idx1.size();
+            }
+        }
+    };
+    runTasks(pool, strip_count, fillStrip);
+
+    // Fan of the last layer around its first vertex
+    if (last_size >= 3) {
+        Layer idx = layers.back();
+        size_t slots = layer_offsets[layers.size() - 1];
+        for (size_t index = 1; index + 1 < idx.size(); ++index) {
+            size_t t = offsets[strip_count] + index - 1;
+            mesh.triangles[3 * t] = idx[0];
+            mesh.triangles[3 * t + 1] = idx[index];
+            mesh.triangles[3 * t + 2] = idx[index + 1];
+
+            if (index == 1)
+                inside[slots] = Index(3 * t);
+            else
+                link(3 * t, 3 * (t - 1) + 2);
+            inside[slots + index] = Index(3 * t + 1);
+            if (index + 2 == idx.size())
+                inside[slots + index + 1] = Index(3 * t + 2);
+        }
+    }
+
+    // Pair the two sides of every layer edge. A last layer of two points is a slit
+    // whose sides face each other.
+    runTasks(pool, layers.size(), [&](size_t layer_i, unsigned) {
+        size_t size = layers[layer_i].size(), slots = layer_offsets[layer_i];
+        if (size == 2 && layer_i + 1 == layers.size()) {
+            if (outside[slots] != NONE && outside[slots + 1] != NONE)
+                link(outside[slots], outside[slots + 1]);
+        } else if (size > 1) {
+            for (size_t i = slots; i < slots + size; ++i) {
+                if (inside[i] != NONE && outside[i] != NONE)
+                    link(inside[i], outside[i]);
+            }
+        }
+    });
+
+    // Flips change the triangles, the rest of the connectivity waits for them
+    if (options.delaunayFlips && !mesh.triangles.empty())
+        return;
+
+    findNeighbors(twins);
+    if (options.topology != MESH_HALF_EDGES)
+        return;
+
+    mesh.halfedges.swap(twins);
+
+    // Every vertex leaves along its layer edge, from the triangle inside the layer when there is one
+    mesh.vertexEdges.assign(point_count, NONE);
+    runTasks(pool, layers.size(), [&](size_t layer_i, unsigned) {
+        Layer idx = layers[layer_i];
+        size_t slots = layer_offsets[layer_i];
+        if (idx.size() == 1) {
+            if (layer_i > 0)
+                mesh.vertexEdges[idx[0]] = Index(3 * offsets[layer_i - 1] + 2);
+            return;
+        }
+        for (size_t i = 0; i < idx.size(); ++i) {
+            Index edge = inside[slots + i];
+            mesh.vertexEdges[idx[i]] = edge != NONE ? edge : outside[slots + (i + idx.size() - 1) % idx.size()];
+        }
+    });
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::findNeighbors(const std::vector<Index> &twins)
+{
+    const Index NONE = mesh.NONE;
+    mesh.neighbors.resize(twins.size());
+    size_t parts = pool ? pool->size() : 1;
+    runTasks(pool, parts, [&](size_t part, unsigned) {
+        size_t begin, end;
+        blockRange(twins.size(), parts, part, begin, end);
+        for (size_t edge = begin; edge < end; ++edge)
+            mesh.neighbors[edge] = twins[edge] == NONE ? NONE : twins[edge] / 3;
+    });
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::flipEdges(const Points &points)
+{
+    std::vector<Index> &twins = workspace->twins;
+    if (mesh.triangles.empty())
+        return;
+    stats.flips = flipToDelaunay(points, mesh.triangles, twins, pool, workspace->flips);
+
+    // The layers no longer tell the sides apart, so the edges become all edges of the triangles:
+    // one per pair of twins and one per hull half-edge
+    const Index NONE = mesh.NONE;
+    size_t hull_edges = std::count(twins.begin(), twins.end(), NONE);
+    edges.clear();
+    edges.reserve((twins.size() + hull_edges) / 2);
+    for (size_t edge = 0; edge < twins.size(); ++edge) {
+        if (twins[edge] == NONE || size_t(twins[edge]) > edge)
+            edges.push_back(std::make_pair(mesh.triangles[edge], mesh.triangles[mesh.next(Index(edge))]));
+    }
+    flipped = true;
+
+    if (options.topology == MESH_EDGES_ONLY) {
+        mesh.clear();
+        return;
+    }
+
+    findNeighbors(twins);
+    if (options.topology != MESH_HALF_EDGES)
+        return;
+
+    mesh.halfedges.swap(twins);
+
+    // Any half-edge leaving a vertex, the hull edge for hull vertices
+    mesh.vertexEdges.assign(points.size(), NONE);
+    for (size_t edge = 0; edge < mesh.halfedges.size(); ++edge) {
+        Index vertex = mesh.triangles[edge];
+        if (mesh.vertexEdges[vertex] == NONE || mesh.halfedges[edge] == NONE)
+            mesh.vertexEdges[vertex] = Index(edge);
+    }
+}
+
+template <typename Coord, typename Index>
+bool BasicLayerTriangulation<Coord, Index>::insertPoints(const Coord *x, const Coord *y, size_t count, EdgeChanges &changes)
+{
+    changes.added.clear();
+    changes.removed.clear();
+    if (flipped || coordinates.size() + count > size_t(std::numeric_limits<Index>::max()))
+        return false;
+    if (count == 0)
+        return true;
+
+    size_t first = coordinates.size();
+    coordinates.append(x, y, count);
+    if (!erased.empty())
+        erased.resize(coordinates.size(), false);
+    if (!duplicates.rank.empty()) {
+        for (size_t point = first; point < coordinates.size(); ++point) {
+            duplicates.rank.push_back(Index(duplicates.unique.size()));
+            duplicates.unique.push_back(Index(point));
+        }
+    }
+
+    workspace->inserted.clear();
+    for (size_t point = first; point < coordinates.size(); ++point)
+        workspace->inserted.push_back(Index(point));
+    workspace->erased.clear();
+    repairLayers(changes);
+    return true;
+}
+
+template <typename Coord, typename Index>
+bool BasicLayerTriangulation<Coord, Index>::erasePoints(const Index *indices, size_t count, EdgeChanges &changes)
+{
+    changes.added.clear();
+    changes.removed.clear();
+    if (flipped)
+        return false;
+    if (count == 0)
+        return true;
+
+    erased.resize(coordinates.size(), false);
+    for (size_t i = 0; i < count; ++i) {
+        size_t point = size_t(indices[i]);
+        if (point >= coordinates.size() || erased[point]) {
+            for (size_t j = 0; j < i; ++j)
+                erased[size_t(indices[j])] = false;
+            return false;
+        }
+        erased[point] = true;
+    }
+
+    workspace->inserted.clear();
+    workspace->erased.assign(indices, indices + count);
+    repairLayers(changes);
+    return true;
+}
+
+template <typename Coord, typename Index>
+size_t BasicLayerTriangulation<Coord, Index>::pointDepth(size_t point) const
+{
+    // The layers are nested, so those strictly containing the point come first
+    size_t low = 0, high = layers.size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (strictlyInside(coordinates, layers[middle], point))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+template <typename Coord, typename Index>
+void BasicLayerTriangulation<Coord, Index>::repairLayers(EdgeChanges &changes)
+{
+    TriangulationWorkspace<Index> &space = *workspace;
+    const std::vector<Index> &inserted = space.inserted, &removed = space.erased;
+    size_t layer_count = layers.size();
+
+    // Layers outside the outermost changed one stay as they are. A new point changes the first
+    // layer not strictly containing it, a removed point the layer it is a vertex of.
+    size_t first = layer_count, last = 0;
+    for (Index point : inserted) {
+        size_t depth = pointDepth(size_t(point));
+        first = std::min(first, depth);
+        last = std::max(last, depth);
+    }
+    for (Index point : removed) {
+        size_t depth = pointDepth(size_t(point));
+        while (std::find(layers[depth].begin(), layers[depth].end(), point) == layers[depth].end())
+            ++depth;
+        first = std::min(first, depth);
+        last = std::max(last, depth);
+    }
+
+    // balance[p] is 1 if point p is left to peel but no longer part of the old layers, -1 for the
+    // opposite, and unbalanced counts the points with a nonzero balance. Once it drops to zero the
+    // remaining layers are the old ones.
+    std::vector<int8_t> &balance = space.balance;
+    std::vector<uint8_t> &border = space.border;
+    if (balance.size() < coordinates.size()) {
+        balance.resize(coordinates.size(), 0);
+        border.resize(coordinates.size(), 0);
+    }
+    size_t unbalanced = 0;
+    auto shift = [&](Index point, int by) {
+        int8_t &value = balance[size_t(point)];
+        unbalanced -= value != 0;
+        value = int8_t(value + by);
+        unbalanced += value != 0;
+    };
+
+    // Peel a window of layers around the changes. Its innermost layer bounds the points below it,
+    // so the new layers are right as long as none of them takes a vertex of that layer; otherwise
+    // the window doubles.
+    std::vector<Index> &window = space.window;
+    LayerList<Index> &repaired = space.repaired;
+    size_t end = std::min(layer_count, std::max(last + 2, first + REPAIR_MIN_LAYERS));
+    size_t replaced = 0, replacing = 0;
+    for (;;) {
+        window.clear();
+        for (Index point : inserted) {
+            window.push_back(point);
+            shift(point, 1);
+        }
+        for (Index point : removed)
+            shift(point, -1);
+        for (size_t layer_i = first; layer_i < end; ++layer_i) {
+            for (Index point : layers[layer_i]) {
+                if (!erased.size() || !erased[size_t(point)])
+                    window.push_back(point);
+            }
+        }
+        bool bounded = end < layer_count;
+        if (bounded) {
+            for (Index point : layers[end - 1])
+                border[size_t(point)] = 1;
+        }
+
+        repaired.clear();
+        if (!window.empty()) {
+            size_t origin = first > 0 ? size_t(layers[0][0])
+                                      : size_t(window[lowestPoint(coordinates, window.data(), window.size())]);
+            peelConvexLayers(coordinates, window.data(), window.size(), origin, first == 0, repaired, space.peel);
+        }
+
+        // Walk the new and the old layers side by side until the points left over agree
+        bool valid = true;
+        size_t step = 0, old_count = end - first, new_count = repaired.size();
+        while (unbalanced > 0 && (step < new_count || step < old_count)) {
+            if (step < new_count) {
+                for (Index point : repaired[step]) {
+                    valid = valid && !border[size_t(point)];
+                    shift(point, -1);
+                }
+            }
+            if (step < old_count) {
+                for (Index point : layers[first + step])
+                    shift(point, 1);
+            }
+            ++step;
+        }
+
+        if (bounded) {
+            for (Index point : layers[end - 1])
+                border[size_t(point)] = 0;
+        }
+        if (valid && unbalanced == 0) {
+            replaced = std::min(step, old_count);
+            replacing = std::min(step, new_count);
+            break;
+        }
+
+        for (Index point : window)
+            balance[size_t(point)] = 0;
+        for (Index point : removed)
+            balance[size_t(point)] = 0;
+        for (size_t layer_i = first; layer_i < end; ++layer_i) {
+            for (Index point : layers[layer_i])
+                balance[size_t(point)] = 0;
+        }
+        unbalanced = 0;
+        end = std::min(layer_count, first + 2 * (end - first));
+    }
+
+    // Splice the new layers in and find their lowest points
+    LayerList<Index> &previous = space.previousLayers;
+    previous.swap(layers);
+    layers.clear();
+    for (size_t layer_i = 0; layer_i < first; ++layer_i)
+        layers.addLayer(previous[layer_i].begin(), previous[layer_i].end());
+    for (size_t layer_i = 0; layer_i < replacing; ++layer_i)
+        layers.addLayer(repaired[layer_i].begin(), repaired[layer_i].end());
+    for (size_t layer_i = first + replaced; layer_i < layer_count; ++layer_i)
+        layers.addLayer(previous[layer_i].begin(), previous[layer_i].end());
+
+    lowest.erase(lowest.begin() + first, lowest.begin() + first + replaced);
+    lowest.insert(lowest.begin() + first, replacing, Index(0));
+    for (size_t layer_i = first; layer_i < first + replacing; ++layer_i)
+        findLowestPoints(layer_i, coordinates);
+
+    // Strips touching a replaced layer are stitched again, the others move over
+    std::vector<size_t> &old_offsets = space.previousOffsets, &offsets = space.stripOffsets;
+    size_t old_strips = findStripOffsets(previous, old_offsets);
+    size_t strip_count = findStripOffsets(layers, offsets);
+    size_t strip_first = first > 0 ? first - 1 : 0;
+    size_t old_end = std::max(strip_first, std::min(first + replaced, old_strips));
+    size_t new_end = std::max(strip_first, std::min(first + replacing, strip_count));
+    bool fan_changed = first + replaced == layer_count;
+
+    EdgeList &previous_edges = space.previousEdges;
+    previous_edges.swap(edges);
+    edges.reserve(offsets[strip_count] + fanEdgeCount(layers));
+    edges.resize(offsets[strip_count]);
+    std::copy(previous_edges.begin(), previous_edges.begin() + old_offsets[strip_first], edges.begin());
+    std::copy(previous_edges.begin() + old_offsets[old_end], previous_edges.begin() + old_offsets[old_strips],
+              edges.begin() + offsets[new_end]);
+    runTasks(pool, new_end - strip_first, [&](size_t strip, unsigned) {
+        stitchStrip(strip_first + strip, coordinates, edges.data() + offsets[strip_first + strip]);
+    });
+    if (fan_changed && !layers.empty())
+        traingluateLastLayer(coordinates);
+    else if (!fan_changed)
+        edges.insert(edges.end(), previous_edges.begin() + old_offsets[old_strips], previous_edges.end());
+
+    // Edges of the replaced strips, fan and layer sides, without those that are there before and after
+    EdgeList &added = changes.added, &lost = changes.removed;
+    lost.assign(previous_edges.begin() + old_offsets[strip_first], previous_edges.begin() + old_offsets[old_end]);
+    added.assign(edges.begin() + offsets[strip_first], edges.begin() + offsets[new_end]);
+    if (fan_changed) {
+        // The first and the last spoke of a fan are layer sides
+        if (previous_edges.size() > old_offsets[old_strips])
+            lost.insert(lost.end(), previous_edges.begin() + old_offsets[old_strips] + 1, previous_edges.end() - 1);
+        if (edges.size() > offsets[strip_count])
+            added.insert(added.end(), edges.begin() + offsets[strip_count] + 1, edges.end() - 1);
+    }
+    appendSides(previous, first, first + replaced, lost);
+    appendSides(layers, first, first + replacing, added);
+
+    auto normalize = [](EdgeList &list) {
+        for (std::pair<Index,Index> &edge : list) {
+            if (edge.second < edge.first)
+                std::swap(edge.first, edge.second);
+        }
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+    };
+    normalize(added);
+    normalize(lost);
+    size_t i = 0, j = 0, added_size = 0, lost_size = 0;
+    while (i < added.size() && j < lost.size()) {
+        if (added[i] < lost[j]) {
+            added[added_size++] = added[i++];
+        } else if (lost[j] < added[i]) {
+            lost[lost_size++] = lost[j++];
+        } else {
+            ++i;
+            ++j;
+        }
+    }
+    while (i < added.size())
+        added[added_size++] = added[i++];
+    while (j < lost.size())
+        lost[lost_size++] = lost[j++];
+    added.resize(added_size);
+    lost.resize(lost_size);
+
+    if (options.topology != MESH_EDGES_ONLY)
+        buildMesh(strip_count, coordinates.size());
+
+    location.clear();
+    if (options.locationIndex && !mesh.neighbors.empty())
+        buildLocationIndex(coordinates, layers, mesh, location, pool);
+}
+
+#define INSTANTIATE_LAYER_TRIANGULATION(Coord, Index) \
+    template class BasicLayerTriangulation<Coord, Index>;
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_LAYER_TRIANGULATION)
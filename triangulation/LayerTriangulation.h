@@ -3,44 +3,236 @@
 
 #include <vector>
 #include <algorithm>
+#include <memory>
 
 #include "Point2D.h"
+#include "AngularSort.h"
+#include "ConvexLayers.h"
+#include "DiagonalRules.h"
+#include "Duplicates.h"
+#include "LayerList.h"
+#include "PointArray.h"
+#include "TriangleMesh.h"
+#include "MeshIO.h"
+#include "MeshOrder.h"
+#include "PointLocation.h"
+#include "Stats.h"
+#include "TriangulationWorkspace.h"
+
+class ThreadPool;
+
+struct TriangulationOptions
+{
+    TriangulationOptions();
+
+    // Convex layers extraction
+    LayerEngine layerEngine;
+
+    // Counterclockwise sort of the points around the origin (Graham scan engine only)
+    AngularSortMethod angularSort;
+
+    // Worker threads for the parallel stages, 0 - all hardware threads
+    unsigned threads;
+
+    // Connectivity built besides the edges
+    MeshTopology topology;
 
-class LayerTriangulation
+    // Choice between the two diagonals of a strip step
+    DiagonalRule diagonalRule;
+
+    // Lawson flips after the stitching until the triangulation is Delaunay. The edges then hold
+    // every edge of the triangles.
+    bool delaunayFlips;
+
+    // Build the point location index together with the mesh rather than on the first locate()
+    bool locationIndex;
+
+    // Merge points closer than duplicateTolerance along both axes before peeling; only the first
+    // point of every group is triangulated, the others are left out like erased points. The hull
+    // tree engine needs distinct points and always merges equal ones, with tolerance 0 when
+    // removeDuplicates is off.
+    bool removeDuplicates;
+    real duplicateTolerance;
+
+    // Pool to run the parallel stages on instead of an own one (not owned)
+    ThreadPool *pool;
+};
+
+// Layer triangulation over coordinates of type Coord (float, double, int32_t or int64_t) with
+// point, triangle and edge indices of type Index (int, uint32_t or uint64_t). Predicates convert
+// the coordinates to double, which is exact for all of them as long as int64_t values stay
+// within +-2^53; wider index types lift the 2^31 point limit of int.
+template <typename Coord, typename Index>
+class BasicLayerTriangulation
 {
 public:
-    LayerTriangulation(const std::vector<Point2D> &points);
+    typedef BasicPointArray<Coord> Points;
+    typedef std::vector<std::pair<Index,Index> > EdgeList;
+    typedef typename LayerList<Index>::Layer Layer;
+
+    // Points are converted to Coord, integer types truncate them
+    BasicLayerTriangulation(const std::vector<Point2D> &points, const TriangulationOptions &options = TriangulationOptions());
+
+    // Triangulate coordinate arrays in place, without copying them. The arrays must stay valid
+    // as long as the triangulation is used.
+    BasicLayerTriangulation(const Coord *x, const Coord *y, size_t count, const TriangulationOptions &options = TriangulationOptions());
+
+    // Empty triangulation for triangulate() to fill
+    explicit BasicLayerTriangulation(const TriangulationOptions &options = TriangulationOptions());
+
+    ~BasicLayerTriangulation();
+
+    // Triangulate another point set in place of the current one. The results and the workspace
+    // of the previous triangulation are reused, so a triangulation kept around for many point sets
+    // stops allocating once it has seen the largest of them. The arrays are used without copying.
+    void triangulate(const Coord *x, const Coord *y, size_t count);
+
+    // Edges an update added to the triangulation and removed from it, the layer sides included.
+    // Every edge appears once with the smaller index first; edges removed and added again are
+    // in neither list.
+    struct EdgeChanges
+    {
+        EdgeList added, removed;
+    };
+
+    // Add points, numbered on from the current ones. The coordinates are copied, a triangulation
+    // of caller arrays switches to copies of them. Only the layers from the outermost one not
+    // strictly containing a new point are peeled again, and only until the layers left agree with
+    // the old ones; only the strips next to replaced layers are stitched again. The mesh is rebuilt
+    // in linear time. Returns false, changing nothing, if the points would not fit Index or the
+    // triangulation has been flipped or is a collinear path.
+    bool insertPoints(const Coord *x, const Coord *y, size_t count, EdgeChanges &changes);
+
+    // Remove points, repairing the layers and strips as insertPoints() does. The other points keep
+    // their indices; removed ones stay in the coordinates but belong to no layer, edge or triangle.
+    // Returns false, changing nothing, for an unknown or already removed point, a duplicate left out
+    // or a flipped or collinear triangulation.
+    bool erasePoints(const Index *indices, size_t count, EdgeChanges &changes);
+
+    // Take the scratch memory from a workspace shared with other triangulations (not owned),
+    // nullptr returns to the own one
+    void setWorkspace(TriangulationWorkspace<Index> *shared);
+
+    // Free the scratch memory of the own workspace, leaving only the results. For large inputs
+    // that are triangulated once; the next triangulation or update allocates it again.
+    void releaseWorkspace();
 
     bool saveLaTeX(const std::string &filename, std::vector<Point2D> &points);
 
+    // Coordinates the triangulation refers to, inserted points included
+    const Points &points() const { return coordinates; }
+
+    // True once the edges hold the layer sides as well, after Delaunay flips or for collinear points
+    bool edgesIncludeSides() const { return flipped; }
+
+    // Write the points, triangles and edges in one of the mesh formats
+    bool saveMesh(const std::string &filename, MeshFormat format) const;
+
+    // Copy the triangulation into out renumbered for the locality of mesh walks: the vertices in
+    // order, the triangles and edges sorted after them. The triangulation keeps the input numbering,
+    // out.vertexOrder and out.vertexRank translate between the two. Linear time, on the pool.
+    void orderMesh(MeshOrder order, BasicOrderedMesh<Coord, Index> &out) const;
+
+    // Triangle holding every query point, NONE for points outside the convex hull and for
+    // triangulations without triangles. Points on an edge get either triangle. The queries are
+    // sorted along a Hilbert curve and located in parallel, each walk starting where the one
+    // before ended; the index is built on the first call unless the options asked for it earlier.
+    void locate(const real *x, const real *y, size_t count, Index *triangles);
+
 private:
-    int  selectOrigin(const std::vector<Point2D> &points);
+    void build();
+
+    size_t selectOrigin(const Points &points);
+
+    void sortAngular(std::vector<Index> &indices, const Points &points, size_t origin_i);
+
+    // Peel layers with repeated Graham scans over the angularly sorted points of subset (all
+    // points for nullptr)
+    void extractLayers(size_t origin_i, const Points &points, const Index *subset, size_t count);
+
+    // Points all on one line: their path is the triangulation, its ends the only layer
+    void connectCollinear(const Index *subset, size_t count);
 
     // Simple triangulation
-    void triangulate0(int layer0, int layer1, const std::vector<Point2D> &points);
+    void triangulate0(size_t layer0, size_t layer1, const Points &points, EdgeList &out);
+
+    // Walk around both layers, choosing the diagonals with Rule
+    template <typename Rule>
+    void triangulate1(size_t layer0, size_t layer1, const Points &points, std::pair<Index,Index> *out);
+
+    // Stitch all pairs of adjacent layers, in parallel when a pool is available
+    void triangulateLayers(const Points &points);
+
+    // Stitch strip_i with the diagonal rule of the options
+    void stitchStrip(size_t strip_i, const Points &points, std::pair<Index,Index> *out);
+
+    void traingluateLastLayer(const Points &points);
 
-    // Maximized minimal angle
-    void triangulate1(int layer0, int layer1, const std::vector<Point2D> &points);
+    // Turn the spokes of every strip and the fan of the last layer into mesh triangles
+    void buildMesh(size_t strip_count, size_t point_count);
 
-    void traingluateLastLayer(const std::vector<Point2D> &points);
+    // Neighbors across the paired half-edges
+    void findNeighbors(const std::vector<Index> &twins);
+
+    // Flip the mesh to the Delaunay triangulation and rebuild the edges and the connectivity
+    void flipEdges(const Points &points);
+
+    // Number of layers strictly containing a point
+    size_t pointDepth(size_t point) const;
+
+    // Peel the layers again around the points in workspace->inserted and workspace->erased and
+    // stitch the strips next to the replaced layers
+    void repairLayers(EdgeChanges &changes);
 
     // Find outer convex polygon (0-level)
-    void grahamScan0(const std::vector<int> &indices, const std::vector<Point2D> &points,
-                    std::vector<int> &inner);
+    void grahamScan0(const std::vector<Index> &indices, const Points &points,
+                    std::vector<Index> &inner);
 
     // Find inner convex polygon (k-level, k > 0)
-    void grahamScan1(const std::vector<int> &indices, const std::vector<Point2D> &points,
-                     std::vector<int> &inner);
+    void grahamScan1(const std::vector<Index> &indices, const Points &points,
+                     std::vector<Index> &inner);
+
+    void findLowestPoints(size_t layer_i, const Points &points);
 
-    void findLowestPoints(int layer_i, const std::vector<Point2D> &points);
+    TriangulationOptions options;
+    std::unique_ptr<ThreadPool> ownPool;
+    ThreadPool *pool;
+
+    // Input coordinates as separate x and y arrays for the vector kernels
+    Points coordinates;
+
+    TriangulationWorkspace<Index> ownWorkspace;
+    TriangulationWorkspace<Index> *workspace;
+
+    // The edges include the layer sides
+    bool flipped;
+
+    // Points taken out by erasePoints(), empty before the first removal
+    std::vector<bool> erased;
 
 public:
 
-    std::vector<std::vector<int> > layers;
-    std::vector<int> lowest;
+    // Convex layers, outermost first, counterclockwise
+    LayerList<Index> layers;
+    std::vector<Index> lowest;
+
+    // Edges between the layers, the layer sides are not repeated here. After Delaunay flips
+    // every edge of the triangulation once.
+    EdgeList edges;
 
-    std::vector<std::pair<int,int> > edges;
+    BasicTriangleMesh<Index> mesh;
+
+    // Groups of duplicates found when the options remove them, empty otherwise
+    DuplicateMap<Index> duplicates;
+
+    // Layer centers and a triangle of every vertex for locate(), empty until it is built
+    LocationIndex<Index> location;
+
+    // Phase times and counters of the construction
+    TriangulationStats stats;
 
 };
 
+typedef BasicLayerTriangulation<real, int> LayerTriangulation;
+
 #endif // TRIANGULATION_H
@@ -0,0 +1,358 @@
+#include "MeshIO.h"
+#include "PointIO.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+BufferedWriter::BufferedWriter(const std::string &filename, size_t capacity) :
+    file(fopen(filename.c_str(), "wb")), buffer(capacity), used(0), written(0), failed(false)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    close();
+}
+
+void BufferedWriter::write(const void *data, size_t size)
+{
+    const char *bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        if (used == buffer.size())
+            flush();
+        size_t chunk = std::min(size, buffer.size() - used);
+        memcpy(buffer.data() + used, bytes, chunk);
+        used += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+}
+
+void BufferedWriter::writeText(const char *text)
+{
+    write(text, strlen(text));
+}
+
+void BufferedWriter::writeNumber(double value)
+{
+    // Shortest representation that reads back to the same value
+    if (buffer.size() - used < 32)
+        flush();
+    std::to_chars_result result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+    used = size_t(result.ptr - buffer.data());
+}
+
+void BufferedWriter::writeNumber(long long value)
+{
+    if (buffer.size() - used < 32)
+        flush();
+    std::to_chars_result result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+    used = size_t(result.ptr - buffer.data());
+}
+
+void BufferedWriter::writeZeros(size_t size)
+{
+    static const char zeros[64] = { 0 };
+    while (size > 0) {
+        size_t chunk = std::min(size, sizeof(zeros));
+        write(zeros, chunk);
+        size -= chunk;
+    }
+}
+
+void BufferedWriter::writeVarint(uint64_t value)
+{
+    // Seven bits per byte, low ones first, the high bit set on all bytes but the last
+    if (buffer.size() - used < 10)
+        flush();
+    while (value >= 0x80) {
+        buffer[used++] = char(value | 0x80);
+        value >>= 7;
+    }
+    buffer[used++] = char(value);
+}
+
+void BufferedWriter::flush()
+{
+    if (file && used > 0 && fwrite(buffer.data(), 1, used, file) != used)
+        failed = true;
+    written += used;
+    used = 0;
+}
+
+bool BufferedWriter::close()
+{
+    if (!file)
+        return false;
+    flush();
+    if (fclose(file) != 0)
+        failed = true;
+    file = nullptr;
+    return !failed;
+}
+
+namespace {
+
+template <typename Index>
+size_t edgeCount(const std::vector<std::pair<Index,Index> > &edges, const LayerList<Index> &layers)
+{
+    return edges.size() + layerSideCount(layers);
+}
+
+// Call edge(i1, i2) for the edges between layers, then for the layer sides
+template <typename Index, typename Function>
+void forEachEdge(const std::vector<std::pair<Index,Index> > &edges, const LayerList<Index> &layers,
+                 Function edge)
+{
+    for (const std::pair<Index,Index> &e : edges)
+        edge(e.first, e.second);
+    forEachLayerSide(layers, edge);
+}
+
+// Copy values of an array into the writer through a fixed block, converting them to T
+template <typename T, typename Source>
+void writeBlock(BufferedWriter &out, const Source *values, size_t count)
+{
+    T block[4096];
+    for (size_t begin = 0; begin < count; begin += 4096) {
+        size_t size = std::min<size_t>(4096, count - begin);
+        for (size_t i = 0; i < size; ++i)
+            block[i] = T(values[begin + i]);
+        out.write(block, size * sizeof(T));
+    }
+}
+
+template <typename Coord, typename Index>
+void writeBinary(BufferedWriter &out, const BasicPointArray<Coord> &points, const BasicTriangleMesh<Index> &mesh,
+                 const std::vector<std::pair<Index,Index> > &edges, const LayerList<Index> &layers)
+{
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LTMS", 4);
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = points.size();
+    header.triangleCount = mesh.size();
+    header.neighborCount = mesh.neighbors.empty() ? 0 : mesh.size();
+    header.edgeCount = edgeCount(edges, layers);
+
+    header.vertexOffset = alignBlock(sizeof(header));
+    header.triangleOffset = alignBlock(header.vertexOffset + 2 * sizeof(double) * header.vertexCount);
+    header.neighborOffset = alignBlock(header.triangleOffset + 3 * sizeof(int32_t) * header.triangleCount);
+    header.edgeOffset = alignBlock(header.neighborOffset + 3 * sizeof(int32_t) * header.neighborCount);
+
+    out.write(&header, sizeof(header));
+
+    out.writeZeros(size_t(header.vertexOffset - out.position()));
+    writeBlock<double>(out, points.x, points.size());
+    writeBlock<double>(out, points.y, points.size());
+
+    out.writeZeros(size_t(header.triangleOffset - out.position()));
+    writeBlock<int32_t>(out, mesh.triangles.data(), mesh.triangles.size());
+
+    out.writeZeros(size_t(header.neighborOffset - out.position()));
+    writeBlock<int32_t>(out, mesh.neighbors.data(), mesh.neighbors.size());
+
+    out.writeZeros(size_t(header.edgeOffset - out.position()));
+    forEachEdge(edges, layers, [&out](Index i1, Index i2) {
+        int32_t pair[2] = { int32_t(i1), int32_t(i2) };
+        out.write(pair, sizeof(pair));
+    });
+}
+
+template <typename Coord, typename Index>
+void writePLY(BufferedWriter &out, const BasicPointArray<Coord> &points, const BasicTriangleMesh<Index> &mesh,
+              const std::vector<std::pair<Index,Index> > &edges, const LayerList<Index> &layers)
+{
+    out.writeText("ply\nformat binary_little_endian 1.0\nelement vertex ");
+    out.writeNumber((long long)points.size());
+    out.writeText("\nproperty double x\nproperty double y\nproperty double z\n");
+    if (mesh.size() > 0) {
+        out.writeText("element face ");
+        out.writeNumber((long long)mesh.size());
+        out.writeText("\nproperty list uchar int vertex_indices\n");
+    } else {
+        out.writeText("element edge ");
+        out.writeNumber((long long)edgeCount(edges, layers));
+        out.writeText("\nproperty int vertex1\nproperty int vertex2\n");
+    }
+    out.writeText("end_header\n");
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        double vertex[3] = { double(points.x[i]), double(points.y[i]), 0.0 };
+        out.write(vertex, sizeof(vertex));
+    }
+
+    if (mesh.size() > 0) {
+        // Packed records of 13 bytes: count, then three indices
+        char face[13];
+        face[0] = 3;
+        for (size_t t = 0; t < mesh.size(); ++t) {
+            int32_t corners[3] = { int32_t(mesh.triangles[3 * t]), int32_t(mesh.triangles[3 * t + 1]),
+                                   int32_t(mesh.triangles[3 * t + 2]) };
+            memcpy(face + 1, corners, sizeof(corners));
+            out.write(face, sizeof(face));
+        }
+    } else {
+        forEachEdge(edges, layers, [&out](Index i1, Index i2) {
+            int32_t pair[2] = { int32_t(i1), int32_t(i2) };
+            out.write(pair, sizeof(pair));
+        });
+    }
+}
+
+template <typename Coord, typename Index>
+void writeOBJ(BufferedWriter &out, const BasicPointArray<Coord> &points, const BasicTriangleMesh<Index> &mesh,
+              const std::vector<std::pair<Index,Index> > &edges, const LayerList<Index> &layers)
+{
+    for (size_t i = 0; i < points.size(); ++i) {
+        out.writeText("v ");
+        out.writeNumber(double(points.x[i]));
+        out.writeText(" ");
+        out.writeNumber(double(points.y[i]));
+        out.writeText(" 0\n");
+    }
+
+    // OBJ indices start at 1
+    if (mesh.size() > 0) {
+        for (size_t t = 0; t < mesh.size(); ++t) {
+            out.writeText("f");
+            for (int k = 0; k < 3; ++k) {
+                out.writeText(" ");
+                out.writeNumber((long long)mesh.triangles[3 * t + k] + 1);
+            }
+            out.writeText("\n");
+        }
+    } else {
+        forEachEdge(edges, layers, [&out](Index i1, Index i2) {
+            out.writeText("l ");
+            out.writeNumber((long long)i1 + 1);
+            out.writeText(" ");
+            out.writeNumber((long long)i2 + 1);
+            out.writeText("\n");
+        });
+    }
+}
+
+// Difference of two indices, small ones of either sign mapped to small unsigned values
+inline uint64_t zigzag(uint64_t value, uint64_t previous)
+{
+    uint64_t difference = value - previous;
+    return (difference << 1) ^ (0 - (difference >> 63));
+}
+
+inline uint64_t unzigzag(uint64_t code, uint64_t previous)
+{
+    return previous + ((code >> 1) ^ (0 - (code & 1)));
+}
+
+template <typename Index>
+void writeEdgeStream(BufferedWriter &out, size_t vertex_count, const std::vector<std::pair<Index,Index> > &edges,
+                     const LayerList<Index> &layers)
+{
+    EdgeStreamHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LTES", 4);
+    header.version = EDGE_STREAM_VERSION;
+    header.vertexCount = vertex_count;
+    header.edgeCount = edgeCount(edges, layers);
+    out.write(&header, sizeof(header));
+
+    uint64_t first = 0, second = 0;
+    forEachEdge(edges, layers, [&](Index i1, Index i2) {
+        out.writeVarint(zigzag(uint64_t(i1), first));
+        out.writeVarint(zigzag(uint64_t(i2), second));
+        first = uint64_t(i1);
+        second = uint64_t(i2);
+    });
+}
+
+// Next varint of [data, end), false if it runs past the end or beyond 64 bits
+inline bool readVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && data < end; shift += 7) {
+        uint8_t byte = *data++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+}
+
+template <typename Coord, typename Index>
+bool saveMesh(const std::string &filename, MeshFormat format, const BasicPointArray<Coord> &points,
+              const BasicTriangleMesh<Index> &mesh, const std::vector<std::pair<Index,Index> > &edges, const LayerList<Index> &layers)
+{
+    // The compact format and PLY store 32-bit indices
+    bool narrow = format == MESH_FORMAT_BINARY || format == MESH_FORMAT_PLY;
+    if (narrow && (points.size() > size_t(INT32_MAX) || mesh.size() > size_t(INT32_MAX)))
+        return false;
+
+    BufferedWriter out(filename);
+    if (!out.isOpen())
+        return false;
+
+    if (format == MESH_FORMAT_EDGES)
+        writeEdgeStream(out, points.size(), edges, layers);
+    else if (format == MESH_FORMAT_BINARY)
+        writeBinary(out, points, mesh, edges, layers);
+    else if (format == MESH_FORMAT_PLY)
+        writePLY(out, points, mesh, edges, layers);
+    else
+        writeOBJ(out, points, mesh, edges, layers);
+
+    return out.close();
+}
+
+template <typename Index>
+bool loadEdgeStream(const std::string &filename, size_t &vertex_count, std::vector<std::pair<Index,Index> > &edges)
+{
+    MappedFile file;
+    EdgeStreamHeader header;
+    if (!file.open(filename) || file.size() < sizeof(header))
+        return false;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, "LTES", 4) != 0 || header.version != EDGE_STREAM_VERSION ||
+        (header.vertexCount > 0 && header.vertexCount - 1 > uint64_t(std::numeric_limits<Index>::max())))
+        return false;
+
+    // Every edge takes two bytes at least, which bounds the reservation for damaged counts
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(file.data()) + sizeof(header);
+    const uint8_t *end = reinterpret_cast<const uint8_t*>(file.data()) + file.size();
+    if (header.edgeCount > uint64_t(end - data) / 2)
+        return false;
+
+    edges.clear();
+    edges.reserve(size_t(header.edgeCount));
+    uint64_t first = 0, second = 0;
+    for (uint64_t edge = 0; edge < header.edgeCount; ++edge) {
+        uint64_t code1, code2;
+        if (!readVarint(data, end, code1) || !readVarint(data, end, code2))
+            return false;
+        first = unzigzag(code1, first);
+        second = unzigzag(code2, second);
+        if (first >= header.vertexCount || second >= header.vertexCount)
+            return false;
+        edges.push_back(std::make_pair(Index(first), Index(second)));
+    }
+    vertex_count = size_t(header.vertexCount);
+    return data == end;
+}
+
+#define INSTANTIATE_SAVE_MESH(Coord, Index) \
+    template bool saveMesh(const std::string&, MeshFormat, const BasicPointArray<Coord>&, const BasicTriangleMesh<Index>&, \
+                           const std::vector<std::pair<Index,Index> >&, const LayerList<Index>&);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_SAVE_MESH)
+
+#define INSTANTIATE_LOAD_EDGE_STREAM(Index) \
+    template bool loadEdgeStream(const std::string&, size_t&, std::vector<std::pair<Index,Index> >&);
+
+INSTANTIATE_LOAD_EDGE_STREAM(int)
+INSTANTIATE_LOAD_EDGE_STREAM(uint32_t)
+INSTANTIATE_LOAD_EDGE_STREAM(uint64_t)
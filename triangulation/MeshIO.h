@@ -0,0 +1,151 @@
+#ifndef MESHIO_H
+#define MESHIO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LayerList.h"
+#include "PointArray.h"
+#include "TriangleMesh.h"
+
+enum MeshFormat
+{
+    MESH_FORMAT_BINARY, // Compact block format below
+    MESH_FORMAT_PLY,    // Binary little-endian PLY
+    MESH_FORMAT_OBJ,    // Wavefront OBJ
+    MESH_FORMAT_EDGES   // Delta-encoded edge stream below, without points and triangles
+};
+
+// Header of the compact mesh format, little-endian. Every block starts at a multiple of 64
+// bytes and can be used straight from a memory mapping:
+//   vertices  - planar float64, all x then all y
+//   triangles - int32 vertex triples, counterclockwise
+//   neighbors - int32 triangle across every half-edge, -1 on the hull
+//   edges     - int32 vertex pairs, every edge of the triangulation once
+// Blocks with a zero count are empty, their offset is the end of the previous block.
+struct MeshFileHeader
+{
+    char     magic[4];      // "LTMS"
+    uint32_t version;       // 1
+    uint64_t vertexCount;
+    uint64_t triangleCount;
+    uint64_t neighborCount; // triangleCount or 0
+    uint64_t edgeCount;
+    uint64_t vertexOffset;
+    uint64_t triangleOffset;
+    uint64_t neighborOffset;
+    uint64_t edgeOffset;
+};
+
+const uint32_t MESH_FILE_VERSION = 1;
+
+// Header of the edge stream, little-endian, for archiving a triangulation of a point file kept
+// alongside. edgeCount edges follow, each as two LEB128 varints: the zigzag-encoded differences
+// of its first and its second vertex to those of the edge before. Neighboring spokes of a strip
+// share a vertex, so one difference is mostly zero; vertices numbered along a curve make the
+// other one short as well.
+struct EdgeStreamHeader
+{
+    char     magic[4];      // "LTES"
+    uint32_t version;       // 1
+    uint64_t vertexCount;
+    uint64_t edgeCount;
+};
+
+const uint32_t EDGE_STREAM_VERSION = 1;
+
+// Start of a block of the compact format that follows offset
+inline uint64_t alignBlock(uint64_t offset)
+{
+    return (offset + 63) & ~uint64_t(63);
+}
+
+// Writes through a large buffer, so the file sees a few big writes only
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(const std::string &filename, size_t capacity = size_t(1) << 22);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter &operator=(const BufferedWriter&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    void write(const void *data, size_t size);
+    void writeText(const char *text);
+    void writeNumber(double value);
+    void writeNumber(long long value);
+    void writeZeros(size_t size);
+    void writeVarint(uint64_t value);
+
+    uint64_t position() const { return written + used; }
+
+    // Flush and close the file, false if anything failed
+    bool close();
+
+private:
+    void flush();
+
+    FILE *file;
+    std::vector<char> buffer;
+    size_t used;
+    uint64_t written;
+    bool failed;
+};
+
+// Sides of layer layer_i that are no edges between the layers, as the range [first, last) of
+// side i running from vertex i to the next one: a polygon has one per vertex, a segment one and
+// a point none. The fan of a last layer with more than three vertices starts and ends with a
+// side, so those two are among the edges already.
+template <typename Index>
+inline void layerSides(const LayerList<Index> &layers, size_t layer_i, size_t &first, size_t &last)
+{
+    size_t size = layers[layer_i].size();
+    bool fan = layer_i + 1 == layers.size() && size > 3;
+    first = fan ? 1 : 0;
+    last = fan ? size - 1 : size >= 3 ? size : size - (size > 0);
+}
+
+template <typename Index>
+size_t layerSideCount(const LayerList<Index> &layers)
+{
+    size_t count = 0, first, last;
+    for (size_t layer_i = 0; layer_i < layers.size(); ++layer_i) {
+        layerSides(layers, layer_i, first, last);
+        count += last - first;
+    }
+    return count;
+}
+
+// Call side(i1, i2) for the sides layerSides() gives of every layer
+template <typename Index, typename Function>
+void forEachLayerSide(const LayerList<Index> &layers, Function side)
+{
+    size_t first, last;
+    for (size_t layer_i = 0; layer_i < layers.size(); ++layer_i) {
+        typename LayerList<Index>::Layer layer = layers[layer_i];
+        layerSides(layers, layer_i, first, last);
+        for (size_t i = first; i < last; ++i)
+            side(layer[i], layer[(i + 1) % layer.size()]);
+    }
+}
+
+// Write the points and the mesh triangles. edges are the edges between layers, the sides of the
+// layers are appended to them as forEachLayerSide() lists them. Without triangles PLY and OBJ
+// files get the edges instead. Coordinates are written as double; the compact format and PLY
+// fail for more than 2^31 - 1 points.
+template <typename Coord, typename Index>
+bool saveMesh(const std::string &filename, MeshFormat format, const BasicPointArray<Coord> &points,
+              const BasicTriangleMesh<Index> &mesh, const std::vector<std::pair<Index,Index> > &edges,
+              const LayerList<Index> &layers);
+
+// Read the edges of an edge stream into an exactly sized edges. False for a damaged file or one
+// whose vertices would not fit Index.
+template <typename Index>
+bool loadEdgeStream(const std::string &filename, size_t &vertex_count, std::vector<std::pair<Index,Index> > &edges);
+
+#endif // MESHIO_H
@@ -0,0 +1,197 @@
+#include "MeshOrder.h"
+#include "RadixSort.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+
+// Resolution of the curves along both axes
+const real CURVE_CELLS = 65535.0;
+
+}
+
+template <typename Coord, typename Index>
+bool BasicOrderedMesh<Coord, Index>::save(const std::string &filename, MeshFormat format) const
+{
+    BasicPointArray<Coord> points;
+    points.view(x.data(), y.data(), x.size());
+    return saveMesh(filename, format, points, mesh, edges, LayerList<Index>());
+}
+
+template <typename Coord, typename Index>
+void curveOrder(const BasicPointArray<Coord> &points, MeshOrder order, std::vector<Index> &sorted,
+                MeshOrderBuffers<Index> &buffers, ThreadPool *pool)
+{
+    size_t count = points.size();
+    sorted.resize(count);
+    if (count == 0)
+        return;
+
+    std::vector<real> &bounds = buffers.bounds;
+    boundingBox(points, bounds, pool);
+    size_t parts = blockCount(pool, count);
+
+    // Square cells keep the curve from stretching along the longer side
+    real min_x = bounds[0], min_y = bounds[1];
+    real span = std::max(bounds[2] - min_x, bounds[3] - min_y);
+    real scale = span > 0 ? CURVE_CELLS / span : 0;
+
+    // Key in the upper bits, position in the lower ones. Point sets too large to leave the key
+    // all 32 bits use a coarser curve, dropping its last levels.
+    unsigned index_bits = valueBits(count);
+    unsigned key_bits = std::min(32u, 64 - index_bits) & ~1u;
+    std::vector<uint64_t> &items = buffers.items;
+    items.resize(count);
+    forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t cx = uint32_t(std::min(CURVE_CELLS, (real(points.x[i]) - min_x) * scale));
+            uint32_t cy = uint32_t(std::min(CURVE_CELLS, (real(points.y[i]) - min_y) * scale));
+            uint32_t key = order == MESH_ORDER_MORTON ? mortonKey(cx, cy) : hilbertKey(cx, cy);
+            items[i] = (uint64_t(key >> (32 - key_bits)) << index_bits) | i;
+        }
+    });
+
+    radixSort(items, buffers.scratch, buffers.counts, index_bits, key_bits, pool);
+
+    uint64_t mask = index_bits < 64 ? (uint64_t(1) << index_bits) - 1 : ~uint64_t(0);
+    forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            sorted[i] = Index(items[i] & mask);
+    });
+}
+
+template <typename Index>
+void renumberTriangles(const BasicTriangleMesh<Index> &mesh, const std::vector<Index> &rank, size_t vertex_count,
+                       BasicTriangleMesh<Index> &out, std::vector<Index> &triangle_order,
+                       MeshOrderBuffers<Index> &buffers, ThreadPool *pool)
+{
+    const Index NONE = mesh.NONE;
+    size_t triangle_count = mesh.size();
+    out.clear();
+    triangle_order.resize(triangle_count);
+
+    // Sort key of a triangle: its smallest vertex, the corner holding it becomes the first one
+    std::vector<uint64_t> &items = buffers.items;
+    std::vector<uint8_t> &turns = buffers.turns;
+    items.resize(triangle_count);
+    turns.resize(triangle_count);
+    unsigned triangle_bits = valueBits(triangle_count), vertex_bits = valueBits(vertex_count);
+    unsigned key_bits = std::min(vertex_bits, 64 - triangle_bits), drop = vertex_bits - key_bits;
+    size_t parts = blockCount(pool, triangle_count);
+    forBlocks(pool, parts, triangle_count, [&](size_t, size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            uint8_t turn = 0;
+            Index first = rank[mesh.triangles[3 * t]];
+            for (uint8_t k = 1; k < 3; ++k) {
+                Index vertex = rank[mesh.triangles[3 * t + k]];
+                if (vertex < first) {
+                    first = vertex;
+                    turn = k;
+                }
+            }
+            turns[t] = turn;
+            items[t] = ((uint64_t(first) >> drop) << triangle_bits) | t;
+        }
+    });
+
+    radixSort(items, buffers.scratch, buffers.counts, triangle_bits, key_bits, pool);
+
+    std::vector<Index> &triangle_rank = buffers.triangleRank;
+    triangle_rank.resize(triangle_count);
+    uint64_t mask = triangle_bits < 64 ? (uint64_t(1) << triangle_bits) - 1 : ~uint64_t(0);
+    forBlocks(pool, parts, triangle_count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            triangle_order[i] = Index(items[i] & mask);
+            triangle_rank[triangle_order[i]] = Index(i);
+        }
+    });
+
+    // Half-edge k of a triangle turned by turn was half-edge k + turn of it
+    auto moved = [&](Index edge) {
+        if (edge == NONE)
+            return NONE;
+        size_t t = size_t(edge) / 3;
+        return Index(3 * size_t(triangle_rank[t]) + (size_t(edge) % 3 + 3 - turns[t]) % 3);
+    };
+
+    out.triangles.resize(mesh.triangles.size());
+    out.neighbors.resize(mesh.neighbors.size());
+    out.halfedges.resize(mesh.halfedges.size());
+    forBlocks(pool, parts, triangle_count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t t = size_t(triangle_order[i]);
+            for (size_t k = 0; k < 3; ++k) {
+                size_t edge = 3 * t + (k + turns[t]) % 3;
+                out.triangles[3 * i + k] = rank[mesh.triangles[edge]];
+                if (!mesh.neighbors.empty()) {
+                    Index neighbor = mesh.neighbors[edge];
+                    out.neighbors[3 * i + k] = neighbor == NONE ? NONE : triangle_rank[neighbor];
+                }
+                if (!mesh.halfedges.empty())
+                    out.halfedges[3 * i + k] = moved(mesh.halfedges[edge]);
+            }
+        }
+    });
+
+    if (mesh.vertexEdges.empty())
+        return;
+    out.vertexEdges.assign(vertex_count, NONE);
+    forBlocks(pool, blockCount(pool, rank.size()), rank.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            if (rank[v] != NONE && v < mesh.vertexEdges.size())
+                out.vertexEdges[rank[v]] = moved(mesh.vertexEdges[v]);
+        }
+    });
+}
+
+template <typename Index>
+void renumberEdges(std::vector<std::pair<Index,Index> > &edges, const std::vector<Index> &rank, size_t vertex_count,
+                   MeshOrderBuffers<Index> &buffers, ThreadPool *pool)
+{
+    size_t count = edges.size(), parts = blockCount(pool, count);
+    forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Index a = rank[edges[i].first], b = rank[edges[i].second];
+            edges[i] = a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+        }
+    });
+
+    // Both vertices fit one key unless there are more than 2^32 of them
+    unsigned vertex_bits = valueBits(vertex_count);
+    if (2 * vertex_bits <= 64) {
+        std::vector<uint64_t> &items = buffers.items;
+        items.resize(count);
+        uint64_t mask = vertex_bits < 64 ? (uint64_t(1) << vertex_bits) - 1 : ~uint64_t(0);
+        forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                items[i] = (uint64_t(edges[i].first) << vertex_bits) | uint64_t(edges[i].second);
+        });
+        radixSort(items, buffers.scratch, buffers.counts, 0, 2 * vertex_bits, pool);
+        forBlocks(pool, parts, count, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                edges[i] = std::make_pair(Index(items[i] >> vertex_bits), Index(items[i] & mask));
+        });
+    } else {
+        std::sort(edges.begin(), edges.end());
+    }
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+}
+
+#define INSTANTIATE_MESH_ORDER(Coord, Index) \
+    template struct BasicOrderedMesh<Coord, Index>; \
+    template void curveOrder(const BasicPointArray<Coord>&, MeshOrder, std::vector<Index>&, MeshOrderBuffers<Index>&, \
+                             ThreadPool*);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_MESH_ORDER)
+
+#define INSTANTIATE_RENUMBER(Index) \
+    template void renumberTriangles(const BasicTriangleMesh<Index>&, const std::vector<Index>&, size_t, \
+                                    BasicTriangleMesh<Index>&, std::vector<Index>&, MeshOrderBuffers<Index>&, \
+                                    ThreadPool*); \
+    template void renumberEdges(std::vector<std::pair<Index,Index> >&, const std::vector<Index>&, size_t, \
+                                MeshOrderBuffers<Index>&, ThreadPool*);
+
+INSTANTIATE_RENUMBER(int)
+INSTANTIATE_RENUMBER(uint32_t)
+INSTANTIATE_RENUMBER(uint64_t)
@@ -0,0 +1,113 @@
+#ifndef MESHORDER_H
+#define MESHORDER_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MeshIO.h"
+#include "PointArray.h"
+#include "TriangleMesh.h"
+
+class ThreadPool;
+
+// Vertex numbering of a mesh handed to its consumers
+enum MeshOrder
+{
+    MESH_ORDER_INPUT,   // Input order, only the removed points are left out
+    MESH_ORDER_HILBERT, // Along a Hilbert curve through the bounding box
+    MESH_ORDER_MORTON,  // Along a Morton (Z-order) curve through the bounding box
+    MESH_ORDER_LAYERS   // Layer after layer from the outermost, counterclockwise in each
+};
+
+// Position of the cell (x, y) of a 2^16 x 2^16 grid along the Hilbert curve
+inline uint32_t hilbertKey(uint32_t x, uint32_t y)
+{
+    const uint32_t side = uint32_t(1) << 16;
+    uint32_t key = 0;
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) != 0, ry = (y & s) != 0;
+        key += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return key;
+}
+
+// Position of the cell (x, y) of a 2^16 x 2^16 grid along the Morton curve: the bits interleaved
+inline uint32_t mortonKey(uint32_t x, uint32_t y)
+{
+    auto spread = [](uint32_t v) {
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        return (v | (v << 1)) & 0x55555555u;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+// Buffers of the reordering, kept by the caller to reuse them
+template <typename Index>
+struct MeshOrderBuffers
+{
+    std::vector<uint64_t> items, scratch;
+    std::vector<size_t> counts;
+    std::vector<real> bounds;
+    std::vector<Index> triangleRank;
+    std::vector<uint8_t> turns;
+};
+
+// A triangulation renumbered for locality by BasicLayerTriangulation::orderMesh(). Vertices
+// follow the chosen order, triangles the smallest new index of their vertices, which comes first
+// in every triangle, and edges are sorted; so mesh walks touch nearby memory.
+template <typename Coord, typename Index>
+struct BasicOrderedMesh
+{
+    // Coordinates of the vertices in the new order
+    CoordArray<Coord> x, y;
+
+    // Triangles, neighbors, half-edges and vertex edges as far as the topology has them
+    BasicTriangleMesh<Index> mesh;
+
+    // Every edge once, the smaller index first, in increasing order
+    std::vector<std::pair<Index,Index> > edges;
+
+    // Input point of every vertex, and vertex of every input point (NONE for removed points)
+    std::vector<Index> vertexOrder, vertexRank;
+
+    // Triangle of the triangulation's mesh every triangle was taken from
+    std::vector<Index> triangleOrder;
+
+    size_t size() const { return vertexOrder.size(); }
+
+    // Write the mesh in one of the mesh formats
+    bool save(const std::string &filename, MeshFormat format) const;
+};
+
+typedef BasicOrderedMesh<real, int> OrderedMesh;
+
+// All points sorted by their cell along the Hilbert or Morton curve through the bounding box,
+// points of one cell in input order
+template <typename Coord, typename Index>
+void curveOrder(const BasicPointArray<Coord> &points, MeshOrder order, std::vector<Index> &sorted,
+                MeshOrderBuffers<Index> &buffers, ThreadPool *pool);
+
+// Copy mesh with the vertices renamed by rank, NONE for none. Triangles are sorted by their
+// smallest vertex and turned to start with it; triangle_order gets the source of every triangle.
+template <typename Index>
+void renumberTriangles(const BasicTriangleMesh<Index> &mesh, const std::vector<Index> &rank, size_t vertex_count,
+                       BasicTriangleMesh<Index> &out, std::vector<Index> &triangle_order,
+                       MeshOrderBuffers<Index> &buffers, ThreadPool *pool);
+
+// Rename the vertices of edges by rank, put the smaller one first, sort them and drop repeats
+template <typename Index>
+void renumberEdges(std::vector<std::pair<Index,Index> > &edges, const std::vector<Index> &rank, size_t vertex_count,
+                   MeshOrderBuffers<Index> &buffers, ThreadPool *pool);
+
+#endif // MESHORDER_H
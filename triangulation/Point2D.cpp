@@ -6,6 +6,7 @@
 //
 
 #include "Point2D.h"
+#include "Predicates.h"
 #include <cmath>
 
 const real Point2D::Inf = std::numeric_limits<real>::infinity();
@@ -14,12 +15,6 @@ Point2D::Point2D_XY_Compare Point2D::xy_compare = Point2D::Point2D_XY_Compare();
 Point2D::Point2D_YX_Compare Point2D::yx_compare = Point2D::Point2D_YX_Compare();
 
 
-Point2D::Point2D(real _x, real _y) : x(_x), y(_y) {
-}
-
-Point2D::Point2D(const Point2D &point) : x(point.x), y(point.y) {
-}
-
 Point2D::Point2D(std::initializer_list<real> &init)
 {
     if (init.size() == 1) {
@@ -31,46 +26,14 @@ Point2D::Point2D(std::initializer_list<real> &init)
     }
 }
 
-real dotProduct(const Point2D &p1, const Point2D &p2) {
-    return p1.x * p2.x + p1.y * p2.y;
-}
-
-real crossProduct(const Point2D &p1, const Point2D &p2) {
-    return p1.x * p2.y - p1.y * p2.x;
-}
-
 bool operator<(const Point2D &p1, const Point2D &p2) {
     return Point2D::xy_compare(p1, p2);
 }
 
-Point2D operator+(const Point2D &p1, const Point2D &p2) {
-    return Point2D(p1.x + p2.x, p1.y + p2.y);
-}
-
-Point2D operator-(const Point2D &p1, const Point2D &p2) {
-    return Point2D(p1.x - p2.x, p1.y - p2.y);
-}
-
 Point2D operator/(const Point2D &p1, const Point2D &p2) {
     return Point2D(p1.x / p2.x, p1.y / p2.y);
 }
 
-Point2D operator*(const Point2D &p, real value) {
-    return Point2D(p.x * value, p.y * value);
-}
-
-Point2D operator*(real value, const Point2D &p) {
-    return Point2D(p.x * value, p.y * value);
-}
-
-Point2D operator/(const Point2D &p, real value) {
-    return Point2D(p.x / value, p.y / value);
-}
-
-Point2D operator-(const Point2D &p) {
-	return Point2D(-p.x, -p.y);
-}
-
 std::ostream &operator<<(std::ostream &stream, const Point2D &p) {
     stream << "(" << p.x << "," << p.y << ")";
     return stream;
@@ -105,12 +68,6 @@ Point2D &Point2D::operator/=(real value) {
     return *this;
 }
 
-Point2D &Point2D::operator=(const Point2D &p) {
-    this->x = p.x;
-    this->y = p.y;
-    return *this;
-}
-
 real Point2D::operator[](int i) {
     if (i==0) return x;
     else return y;
@@ -125,17 +82,17 @@ void Point2D::setY(real y) {
 }
 
 bool Point2D::isVertical() {
-    return (y == Inf && !isnan(double(x)) && x != Inf);
+    return (y == Inf && !std::isnan(double(x)) && x != Inf);
 }
 
 bool Point2D::isHorizontal() {
-    return (x == Inf && !isnan(double(y)) && y != Inf);
+    return (x == Inf && !std::isnan(double(y)) && y != Inf);
 }
 
 bool Point2D::isValid() {
     if (x == Inf && y == Inf)
         return false;
-    return (!isnan(x) && !isnan(y));
+    return (!std::isnan(x) && !std::isnan(y));
 }
 
 Point2D Point2D::normalized() {
@@ -148,14 +105,6 @@ void Point2D::normalize() {
     y /= n;
 }
 
-real Point2D::norm() {
-    return sqrt(x * x + y * y);
-}
-
-real Point2D::norm2() {
-    return x *x + y * y;
-}
-
 Point2D Point2D::getRotated90CW() {
     return Point2D(y, -x);
 }
@@ -166,24 +115,14 @@ Point2D Point2D::getRotated90CCW() {
 
 bool Point2D::isLeftTurn(const Point2D &p1, const Point2D &p2,
 						 const Point2D &p3) {
-	return (crossProduct(p2 - p1, p3 - p2) > 0.0);
+	return orient2d(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y) > 0.0;
 }
 
 bool Point2D::isRightTurn(const Point2D &p1, const Point2D &p2,
 						  const Point2D &p3) {
-	return (crossProduct(p2 - p1, p3 - p2) < 0.0);
+	return orient2d(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y) < 0.0;
 }
 
 bool equal(const Point2D &p1, const Point2D &p2, real EPSILON) {
     return (fabs(p1.x - p2.x) < EPSILON && fabs(p1.y - p2.y) < EPSILON);
 }
-
-bool equal(real v1, real v2, real EPSILON) {
-    return fabs(v1 - v2) < EPSILON;
-}
-
-
-real distance(const Point2D &p1, const Point2D &p2)
-{
-    return (p1 - p2).norm();
-}
@@ -66,8 +66,8 @@ public:
 
     Point2D normalized();
     void normalize();
-    real norm();
-    real norm2();
+    real norm() const;
+    real norm2() const;
 
     Point2D getRotated90CW();
     Point2D getRotated90CCW();
@@ -87,11 +87,67 @@ public:
 };
 
 bool equal(const Point2D &p1, const Point2D &p2, real EPSILON = POINT_EPSILON);
-bool equal(real v1, real v2, real EPSILON = POINT_EPSILON);
 
-real dotProduct(const Point2D &p1, const Point2D &p2);
-real crossProduct(const Point2D &p1, const Point2D &p2);
+// Arithmetic used by the hot loops is defined here so it can be inlined
 
-real distance(const Point2D &p1, const Point2D &p2);
+inline Point2D::Point2D(real _x, real _y) : x(_x), y(_y) {
+}
+
+inline Point2D::Point2D(const Point2D &point) : x(point.x), y(point.y) {
+}
+
+inline Point2D &Point2D::operator=(const Point2D &p) {
+    this->x = p.x;
+    this->y = p.y;
+    return *this;
+}
+
+inline real dotProduct(const Point2D &p1, const Point2D &p2) {
+    return p1.x * p2.x + p1.y * p2.y;
+}
+
+inline real crossProduct(const Point2D &p1, const Point2D &p2) {
+    return p1.x * p2.y - p1.y * p2.x;
+}
+
+inline Point2D operator+(const Point2D &p1, const Point2D &p2) {
+    return Point2D(p1.x + p2.x, p1.y + p2.y);
+}
+
+inline Point2D operator-(const Point2D &p1, const Point2D &p2) {
+    return Point2D(p1.x - p2.x, p1.y - p2.y);
+}
+
+inline Point2D operator*(const Point2D &p, real value) {
+    return Point2D(p.x * value, p.y * value);
+}
+
+inline Point2D operator*(real value, const Point2D &p) {
+    return Point2D(p.x * value, p.y * value);
+}
+
+inline Point2D operator/(const Point2D &p, real value) {
+    return Point2D(p.x / value, p.y / value);
+}
+
+inline Point2D operator-(const Point2D &p) {
+    return Point2D(-p.x, -p.y);
+}
+
+inline real Point2D::norm() const {
+    return sqrt(x * x + y * y);
+}
+
+inline real Point2D::norm2() const {
+    return x * x + y * y;
+}
+
+inline bool equal(real v1, real v2, real EPSILON = POINT_EPSILON) {
+    return fabs(v1 - v2) < EPSILON;
+}
+
+inline real distance(const Point2D &p1, const Point2D &p2) {
+    return (p1 - p2).norm();
+}
 
 #endif /* POINT2D_H_ */
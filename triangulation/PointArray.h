@@ -0,0 +1,200 @@
+#ifndef POINTARRAY_H
+#define POINTARRAY_H
+
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "Point2D.h"
+#include "PointKernels.h"
+#include "Predicates.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+// Allocator aligning storage for the widest vector loads
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template <typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() {}
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(size_t count) {
+        size_t bytes = count * sizeof(T) + (count == 0);
+#ifdef _WIN32
+        void *memory = _aligned_malloc(bytes, Alignment);
+        if (!memory)
+            throw std::bad_alloc();
+#else
+        void *memory = nullptr;
+        if (posix_memalign(&memory, Alignment, bytes) != 0)
+            throw std::bad_alloc();
+#endif
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T *memory, size_t) {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+template <typename Coord>
+using CoordArray = std::vector<Coord, AlignedAllocator<Coord> >;
+
+typedef CoordArray<real> RealArray;
+
+// Structure of arrays: x and y coordinates kept in separate arrays. The arrays are either
+// owned aligned copies or a view of memory provided by the caller.
+template <typename Coord>
+struct BasicPointArray
+{
+    const Coord *x, *y;
+
+    BasicPointArray() : x(nullptr), y(nullptr), count(0) {}
+    explicit BasicPointArray(const std::vector<Point2D> &points) : BasicPointArray() { assign(points); }
+
+    BasicPointArray(const BasicPointArray&) = delete;
+    BasicPointArray &operator=(const BasicPointArray&) = delete;
+
+    void assign(const std::vector<Point2D> &points) {
+        xs.resize(points.size());
+        ys.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            xs[i] = Coord(points[i].x);
+            ys[i] = Coord(points[i].y);
+        }
+        x = xs.data(); y = ys.data(); count = points.size();
+    }
+
+    // Use the caller's arrays without copying, they must outlive the view
+    void view(const Coord *x_values, const Coord *y_values, size_t size) {
+        CoordArray<Coord>().swap(xs);
+        CoordArray<Coord>().swap(ys);
+        x = x_values; y = y_values; count = size;
+    }
+
+    // Append points, copying a view into own arrays first
+    void append(const Coord *x_values, const Coord *y_values, size_t size) {
+        if (x != xs.data()) {
+            xs.assign(x, x + count);
+            ys.assign(y, y + count);
+        }
+        xs.insert(xs.end(), x_values, x_values + size);
+        ys.insert(ys.end(), y_values, y_values + size);
+        x = xs.data(); y = ys.data(); count += size;
+    }
+
+    size_t size() const { return count; }
+
+    Point2D operator[](size_t i) const { return Point2D(real(x[i]), real(y[i])); }
+
+private:
+    size_t count;
+    CoordArray<Coord> xs, ys;
+};
+
+typedef BasicPointArray<real> PointArray;
+
+// Cross product of (p2 - p1) and (p3 - p1) with an exact sign
+template <typename Coord>
+inline real get_side(const BasicPointArray<Coord> &points, size_t i1, size_t i2, size_t i3)
+{
+    countOrientationTest();
+    return orient2d(real(points.x[i1]), real(points.y[i1]), real(points.x[i2]), real(points.y[i2]),
+                    real(points.x[i3]), real(points.y[i3]));
+}
+
+template <typename Coord>
+inline bool is_ccw(const BasicPointArray<Coord> &points, size_t i1, size_t i2, size_t i3)
+{
+    return get_side(points, i1, i2, i3) >= 0;
+}
+
+// The vector kernels take double coordinates and int indices. Other types, and point sets too
+// large for int indices, use these loops compiled for their own types instead.
+template <typename Coord, typename Index>
+inline bool vectorKernels(const BasicPointArray<Coord> &points)
+{
+    return std::is_same<Coord, double>::value && sizeof(Index) == sizeof(int) &&
+           points.size() <= size_t(std::numeric_limits<int>::max());
+}
+
+// Position in idx[0..count) of the lowest point by y, then by x, all points when idx is null
+template <typename Coord, typename Index>
+size_t lowestPoint(const BasicPointArray<Coord> &points, const Index *idx, size_t count)
+{
+    if constexpr (std::is_same<Coord, double>::value && sizeof(Index) == sizeof(int)) {
+        if (vectorKernels<Coord, Index>(points))
+            return pointKernels().lowest(points.x, points.y, reinterpret_cast<const int*>(idx), count);
+    }
+
+    size_t best = 0;
+    for (size_t i = 1; i < count; ++i) {
+        size_t p = idx ? size_t(idx[i]) : i, q = idx ? size_t(idx[best]) : best;
+        if (points.y[p] < points.y[q] || (points.y[p] == points.y[q] && points.x[p] < points.x[q]))
+            best = i;
+    }
+    return best;
+}
+
+// Bounding box of the points as min x, min y, max x and max y in bounds[0..4). Every block of
+// the pool finds its own first, bounds holds four values per block.
+template <typename Coord>
+void boundingBox(const BasicPointArray<Coord> &points, std::vector<real> &bounds, ThreadPool *pool)
+{
+    size_t count = points.size(), parts = blockCount(pool, count);
+    bounds.resize(4 * parts);
+    forBlocks(pool, parts, count, [&](size_t part, size_t begin, size_t end) {
+        real *box = &bounds[4 * part];
+        box[0] = box[2] = real(points.x[begin]);
+        box[1] = box[3] = real(points.y[begin]);
+        for (size_t i = begin + 1; i < end; ++i) {
+            real x = real(points.x[i]), y = real(points.y[i]);
+            box[0] = std::min(box[0], x);
+            box[1] = std::min(box[1], y);
+            box[2] = std::max(box[2], x);
+            box[3] = std::max(box[3], y);
+        }
+    });
+    for (size_t part = 1; part < parts; ++part) {
+        bounds[0] = std::min(bounds[0], bounds[4 * part]);
+        bounds[1] = std::min(bounds[1], bounds[4 * part + 1]);
+        bounds[2] = std::max(bounds[2], bounds[4 * part + 2]);
+        bounds[3] = std::max(bounds[3], bounds[4 * part + 3]);
+    }
+}
+
+// out[i] = pseudo-angle key of point idx[i] around the origin in the upper 32 bits, i in the lower ones
+template <typename Coord, typename Index>
+void angleKeys(const BasicPointArray<Coord> &points, const Index *idx, size_t count, size_t origin, uint64_t *out)
+{
+    if constexpr (std::is_same<Coord, double>::value && sizeof(Index) == sizeof(int)) {
+        if (vectorKernels<Coord, Index>(points)) {
+            pointKernels().angleKeys(points.x, points.y, reinterpret_cast<const int*>(idx), count,
+                                     points.x[origin], points.y[origin], out);
+            return;
+        }
+    }
+
+    real ox = real(points.x[origin]), oy = real(points.y[origin]);
+    for (size_t i = 0; i < count; ++i)
+        out[i] = (uint64_t(pseudoAngleKey(real(points.x[idx[i]]) - ox, real(points.y[idx[i]]) - oy)) << 32) | uint32_t(i);
+}
+
+#endif // POINTARRAY_H
@@ -0,0 +1,546 @@
+#include "PointIO.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+    memory(nullptr), length(0)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+
+#ifdef _WIN32
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        close();
+        return false;
+    }
+    length = size_t(size.QuadPart);
+    if (length == 0)
+        return true;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        memory = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = size_t(info.st_size);
+    if (length == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address != MAP_FAILED) {
+        memory = static_cast<const char*>(address);
+        madvise(address, length, MADV_SEQUENTIAL);
+    }
+#endif
+
+    if (!memory) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (memory)
+        UnmapViewOfFile(memory);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (memory)
+        munmap(const_cast<char*>(memory), length);
+#endif
+    memory = nullptr;
+    length = 0;
+}
+
+namespace {
+
+bool hasExtension(const std::string &filename, const char *extension)
+{
+    size_t size = strlen(extension);
+    if (filename.size() < size)
+        return false;
+    for (size_t i = 0; i < size; ++i) {
+        if (tolower(filename[filename.size() - size + i]) != extension[i])
+            return false;
+    }
+    return true;
+}
+
+PointFormat resolveFormat(const std::string &filename, PointFormat format)
+{
+    if (format != POINTS_AUTO)
+        return format;
+    if (hasExtension(filename, ".csv") || hasExtension(filename, ".xyz") || hasExtension(filename, ".txt"))
+        return POINTS_TEXT;
+    return POINTS_BINARY;
+}
+
+bool validHeader(const PointFileHeader &header)
+{
+    return memcmp(header.magic, "LTPT", 4) == 0 && header.version == POINT_FILE_VERSION &&
+           header.type <= POINT_F32 && header.layout <= LAYOUT_PLANAR;
+}
+
+// 64-bit file positions on every platform
+bool seekFile(FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, int64_t(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+}
+
+uint64_t fileSize(FILE *file)
+{
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0)
+        return 0;
+    return uint64_t(_ftelli64(file));
+#else
+    if (fseeko(file, 0, SEEK_END) != 0)
+        return 0;
+    return uint64_t(ftello(file));
+#endif
+}
+
+// Convert count values of type T from data to real
+template <typename T>
+void convertValues(const char *data, size_t count, size_t stride, real *out)
+{
+    T value;
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(&value, data + i * stride * sizeof(T), sizeof(T));
+        out[i] = real(value);
+    }
+}
+
+// Points per block of PointReader, and bytes of text read at once
+const size_t READ_BLOCK_POINTS = size_t(1) << 16;
+const size_t READ_BLOCK_TEXT = size_t(1) << 20;
+
+// Convert count interleaved or planar coordinates of type T into separate double arrays
+template <typename T>
+void convert(const char *data, size_t count, PointLayout layout, RealArray &xs, RealArray &ys, ThreadPool *pool)
+{
+    xs.resize(count);
+    ys.resize(count);
+
+    size_t parts = pool ? pool->size() : 1;
+    runTasks(pool, parts, [&](size_t part, unsigned) {
+        size_t begin, end;
+        blockRange(count, parts, part, begin, end);
+
+        T value;
+        for (size_t i = begin; i < end; ++i) {
+            size_t ix = layout == LAYOUT_PLANAR ? i : 2 * i, iy = layout == LAYOUT_PLANAR ? count + i : 2 * i + 1;
+            memcpy(&value, data + ix * sizeof(T), sizeof(T));
+            xs[i] = real(value);
+            memcpy(&value, data + iy * sizeof(T), sizeof(T));
+            ys[i] = real(value);
+        }
+    });
+}
+
+inline bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+inline const char *parseNumber(const char *begin, const char *end, real &value)
+{
+    if (begin != end && *begin == '+')
+        ++begin;
+    std::from_chars_result result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+// Parse the lines of [begin, end). Lines that do not start with two numbers, such as
+// headers and comments, are skipped, further columns (z, attributes) are ignored.
+void parseLines(const char *begin, const char *end, std::vector<real> &xs, std::vector<real> &ys)
+{
+    while (begin < end) {
+        const char *line_end = static_cast<const char*>(memchr(begin, '\n', size_t(end - begin)));
+        if (!line_end)
+            line_end = end;
+
+        const char *it = begin;
+        while (it < line_end && isSeparator(*it))
+            ++it;
+
+        real x, y;
+        it = parseNumber(it, line_end, x);
+        if (it) {
+            while (it < line_end && isSeparator(*it))
+                ++it;
+            if (parseNumber(it, line_end, y)) {
+                xs.push_back(x);
+                ys.push_back(y);
+            }
+        }
+        begin = line_end + 1;
+    }
+}
+
+}
+
+bool PointCloud::load(const std::string &filename, PointFormat format, ThreadPool *pool)
+{
+    x = y = nullptr;
+    count = 0;
+    RealArray().swap(xs);
+    RealArray().swap(ys);
+
+    format = resolveFormat(filename, format);
+    if (!file.open(filename))
+        return false;
+
+    bool loaded = format == POINTS_TEXT ? loadText(pool) : loadBinary(format, pool);
+
+    // The mapping is only kept while the points live in it
+    if (!loaded || x == xs.data())
+        file.close();
+    return loaded;
+}
+
+bool PointCloud::loadBinary(PointFormat format, ThreadPool *pool)
+{
+    PointType type = format == POINTS_RAW_F32 ? POINT_F32 : POINT_F64;
+    PointLayout layout = LAYOUT_INTERLEAVED;
+    size_t offset = 0;
+
+    if (format == POINTS_BINARY) {
+        PointFileHeader header;
+        if (file.size() < sizeof(header))
+            return false;
+        memcpy(&header, file.data(), sizeof(header));
+        if (!validHeader(header))
+            return false;
+
+        type = PointType(header.type);
+        layout = PointLayout(header.layout);
+        offset = size_t(header.dataOffset);
+        count = size_t(header.count);
+    } else {
+        count = file.size() / (type == POINT_F64 ? 2 * sizeof(double) : 2 * sizeof(float));
+    }
+
+    size_t point_bytes = 2 * (type == POINT_F64 ? sizeof(double) : sizeof(float));
+    if (offset > file.size() || count > (file.size() - offset) / point_bytes) {
+        count = 0;
+        return false;
+    }
+
+    const char *data = file.data() + offset;
+
+    // Zero-copy handoff of aligned planar doubles
+    if (type == POINT_F64 && layout == LAYOUT_PLANAR && sizeof(real) == sizeof(double) &&
+        reinterpret_cast<uintptr_t>(data) % alignof(double) == 0) {
+        x = reinterpret_cast<const real*>(data);
+        y = x + count;
+        return true;
+    }
+
+    if (type == POINT_F64)
+        convert<double>(data, count, layout, xs, ys, pool);
+    else
+        convert<float>(data, count, layout, xs, ys, pool);
+    x = xs.data();
+    y = ys.data();
+    return true;
+}
+
+bool PointCloud::loadText(ThreadPool *pool)
+{
+    const char *data = file.data(), *end = data + file.size();
+
+    // Chunks end at line breaks, every chunk is parsed into its own buffers
+    size_t parts = pool ? pool->size() * 4 : 1;
+    std::vector<const char*> bounds(parts + 1, end);
+    bounds[0] = data;
+    for (size_t part = 1; part < parts; ++part) {
+        const char *split = std::max(bounds[part - 1], data + file.size() * part / parts);
+        const char *line_end = split < end ? static_cast<const char*>(memchr(split, '\n', size_t(end - split))) : nullptr;
+        bounds[part] = line_end ? line_end + 1 : end;
+    }
+
+    std::vector<std::vector<real> > chunk_xs(parts), chunk_ys(parts);
+    runTasks(pool, parts, [&](size_t part, unsigned) {
+        parseLines(bounds[part], bounds[part + 1], chunk_xs[part], chunk_ys[part]);
+    });
+
+    std::vector<size_t> offsets(parts + 1, 0);
+    for (size_t part = 0; part < parts; ++part)
+        offsets[part + 1] = offsets[part] + chunk_xs[part].size();
+
+    count = offsets.back();
+    xs.resize(count);
+    ys.resize(count);
+    runTasks(pool, parts, [&](size_t part, unsigned) {
+        std::copy(chunk_xs[part].begin(), chunk_xs[part].end(), xs.begin() + offsets[part]);
+        std::copy(chunk_ys[part].begin(), chunk_ys[part].end(), ys.begin() + offsets[part]);
+        std::vector<real>().swap(chunk_xs[part]);
+        std::vector<real>().swap(chunk_ys[part]);
+    });
+
+    x = xs.data();
+    y = ys.data();
+    return true;
+}
+
+PointReader::PointReader() :
+    file(nullptr), format(POINTS_BINARY), type(POINT_F64), layout(LAYOUT_INTERLEAVED), count(0), position(0),
+    dataOffset(0), pending(0), atEnd(false), error(false)
+{
+}
+
+PointReader::~PointReader()
+{
+    close();
+}
+
+bool PointReader::open(const std::string &filename, PointFormat format)
+{
+    close();
+    this->format = resolveFormat(filename, format);
+    file = fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+
+    type = this->format == POINTS_RAW_F32 ? POINT_F32 : POINT_F64;
+    layout = LAYOUT_INTERLEAVED;
+    dataOffset = 0;
+
+    if (this->format != POINTS_TEXT) {
+        uint64_t size = fileSize(file);
+        size_t point_bytes = 2 * (type == POINT_F64 ? sizeof(double) : sizeof(float));
+        count = size / point_bytes;
+        if (this->format == POINTS_BINARY) {
+            PointFileHeader header;
+            if (!seekFile(file, 0) || fread(&header, sizeof(header), 1, file) != 1 || !validHeader(header)) {
+                close();
+                return false;
+            }
+            type = PointType(header.type);
+            layout = PointLayout(header.layout);
+            dataOffset = header.dataOffset;
+            count = header.count;
+            point_bytes = 2 * (type == POINT_F64 ? sizeof(double) : sizeof(float));
+            if (dataOffset > size || count > (size - dataOffset) / point_bytes) {
+                close();
+                return false;
+            }
+        }
+    }
+    return rewind();
+}
+
+void PointReader::close()
+{
+    if (file)
+        fclose(file);
+    file = nullptr;
+    count = position = 0;
+    buffer.clear();
+    pendingX.clear();
+    pendingY.clear();
+    pending = 0;
+    atEnd = error = false;
+}
+
+bool PointReader::rewind()
+{
+    if (!file)
+        return false;
+    position = 0;
+    buffer.clear();
+    pendingX.clear();
+    pendingY.clear();
+    pending = 0;
+    atEnd = false;
+    error = !seekFile(file, dataOffset);
+    return !error;
+}
+
+size_t PointReader::read(real *x, real *y, size_t capacity)
+{
+    if (!file || error)
+        return 0;
+    return format == POINTS_TEXT ? readText(x, y, capacity) : readBinary(x, y, capacity);
+}
+
+size_t PointReader::readBinary(real *x, real *y, size_t capacity)
+{
+    size_t value_size = type == POINT_F64 ? sizeof(double) : sizeof(float);
+    size_t done = 0;
+    while (done < capacity && position < count && !error) {
+        size_t block = size_t(std::min<uint64_t>(std::min(capacity - done, READ_BLOCK_POINTS), count - position));
+        buffer.resize(2 * block * value_size);
+
+        if (layout == LAYOUT_PLANAR) {
+            // Both halves are read at their own offsets, so the file position moves back and forth
+            char *ys = buffer.data() + block * value_size;
+            error = !seekFile(file, dataOffset + position * value_size) ||
+                    fread(buffer.data(), value_size, block, file) != block ||
+                    !seekFile(file, dataOffset + (count + position) * value_size) ||
+                    fread(ys, value_size, block, file) != block;
+            if (error)
+                break;
+            if (type == POINT_F64) {
+                convertValues<double>(buffer.data(), block, 1, x + done);
+                convertValues<double>(ys, block, 1, y + done);
+            } else {
+                convertValues<float>(buffer.data(), block, 1, x + done);
+                convertValues<float>(ys, block, 1, y + done);
+            }
+        } else {
+            error = fread(buffer.data(), 2 * value_size, block, file) != block;
+            if (error)
+                break;
+            if (type == POINT_F64) {
+                convertValues<double>(buffer.data(), block, 2, x + done);
+                convertValues<double>(buffer.data() + value_size, block, 2, y + done);
+            } else {
+                convertValues<float>(buffer.data(), block, 2, x + done);
+                convertValues<float>(buffer.data() + value_size, block, 2, y + done);
+            }
+        }
+        position += block;
+        done += block;
+    }
+    return done;
+}
+
+size_t PointReader::readText(real *x, real *y, size_t capacity)
+{
+    size_t done = 0;
+    while (done < capacity) {
+        if (pending < pendingX.size()) {
+            size_t size = std::min(capacity - done, pendingX.size() - pending);
+            std::copy(pendingX.begin() + pending, pendingX.begin() + pending + size, x + done);
+            std::copy(pendingY.begin() + pending, pendingY.begin() + pending + size, y + done);
+            pending += size;
+            done += size;
+            continue;
+        }
+        if (atEnd)
+            break;
+
+        // Parse the complete lines of the next block, keep the rest for the one after it
+        size_t kept = buffer.size();
+        buffer.resize(kept + READ_BLOCK_TEXT);
+        size_t got = fread(buffer.data() + kept, 1, READ_BLOCK_TEXT, file);
+        buffer.resize(kept + got);
+        if (got < READ_BLOCK_TEXT) {
+            error = ferror(file) != 0;
+            atEnd = true;
+        }
+
+        const char *begin = buffer.data(), *end = begin + buffer.size();
+        if (!atEnd) {
+            while (end > begin && end[-1] != '\n')
+                --end;
+        }
+        pendingX.clear();
+        pendingY.clear();
+        pending = 0;
+        parseLines(begin, end, pendingX, pendingY);
+        buffer.erase(buffer.begin(), buffer.begin() + (end - begin));
+    }
+    return done;
+}
+
+bool savePoints(const std::string &filename, const real *x, const real *y, size_t count,
+                PointType type, PointLayout layout)
+{
+    FILE *out = fopen(filename.c_str(), "wb");
+    if (!out)
+        return false;
+
+    PointFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LTPT", 4);
+    header.version = POINT_FILE_VERSION;
+    header.type = type;
+    header.layout = layout;
+    header.count = count;
+    header.dataOffset = POINT_FILE_ALIGNMENT;
+
+    char padding[POINT_FILE_ALIGNMENT] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(padding, POINT_FILE_ALIGNMENT - sizeof(header), 1, out) == 1;
+
+    // Convert in blocks so that every fwrite is large
+    const size_t BLOCK = size_t(1) << 16;
+    std::vector<double> doubles;
+    std::vector<float> floats;
+    for (size_t begin = 0; ok && begin < count * 2; begin += BLOCK) {
+        size_t end = std::min(count * 2, begin + BLOCK);
+        doubles.resize(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            if (layout == LAYOUT_PLANAR)
+                doubles[i - begin] = i < count ? x[i] : y[i - count];
+            else
+                doubles[i - begin] = i % 2 == 0 ? x[i / 2] : y[i / 2];
+        }
+
+        if (type == POINT_F64) {
+            ok = fwrite(doubles.data(), sizeof(double), doubles.size(), out) == doubles.size();
+        } else {
+            floats.assign(doubles.begin(), doubles.end());
+            ok = fwrite(floats.data(), sizeof(float), floats.size(), out) == floats.size();
+        }
+    }
+
+    return fclose(out) == 0 && ok;
+}
@@ -0,0 +1,140 @@
+#ifndef POINTIO_H
+#define POINTIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "PointArray.h"
+
+class ThreadPool;
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    bool open(const std::string &filename);
+    void close();
+
+    const char *data() const { return memory; }
+    size_t size() const { return length; }
+
+private:
+    const char *memory;
+    size_t length;
+#ifdef _WIN32
+    void *file, *mapping;
+#endif
+};
+
+enum PointFormat
+{
+    POINTS_AUTO,        // By the file extension: .pts - header format, .csv, .xyz or .txt - text
+    POINTS_BINARY,      // Header format below
+    POINTS_RAW_F64,     // Interleaved x y pairs of doubles, no header
+    POINTS_RAW_F32,     // Interleaved x y pairs of floats, no header
+    POINTS_TEXT         // One point per line, x and y separated by spaces, tabs, commas or semicolons
+};
+
+enum PointType { POINT_F64 = 0, POINT_F32 = 1 };
+
+enum PointLayout
+{
+    LAYOUT_INTERLEAVED = 0, // x0 y0 x1 y1 ...
+    LAYOUT_PLANAR = 1       // x0 x1 ... then y0 y1 ...
+};
+
+// Header of the binary point format, little-endian. The coordinates start at dataOffset,
+// which is a multiple of 64 so that planar doubles can be used straight from the mapping.
+struct PointFileHeader
+{
+    char     magic[4];      // "LTPT"
+    uint32_t version;       // 1
+    uint32_t type;          // PointType
+    uint32_t layout;        // PointLayout
+    uint64_t count;
+    uint64_t dataOffset;
+};
+
+const uint32_t POINT_FILE_VERSION = 1;
+const size_t POINT_FILE_ALIGNMENT = 64;
+
+// Points loaded from a file. Planar doubles of the header format are not copied, x and y point
+// into the mapping then, every other input is converted into owned arrays.
+class PointCloud
+{
+public:
+    PointCloud() : x(nullptr), y(nullptr), count(0) {}
+
+    PointCloud(const PointCloud&) = delete;
+    PointCloud &operator=(const PointCloud&) = delete;
+
+    // Text files are split into chunks parsed in parallel when a pool is given
+    bool load(const std::string &filename, PointFormat format = POINTS_AUTO, ThreadPool *pool = nullptr);
+
+    size_t size() const { return count; }
+
+    const real *x, *y;
+
+private:
+    bool loadBinary(PointFormat format, ThreadPool *pool);
+    bool loadText(ThreadPool *pool);
+
+    size_t count;
+    MappedFile file;
+    RealArray xs, ys;
+};
+
+// Points read from a file a block at a time, for inputs that need not fit into memory. Reads the
+// formats of PointCloud with plain file reads, so nothing but the block stays resident.
+class PointReader
+{
+public:
+    PointReader();
+    ~PointReader();
+
+    PointReader(const PointReader&) = delete;
+    PointReader &operator=(const PointReader&) = delete;
+
+    bool open(const std::string &filename, PointFormat format = POINTS_AUTO);
+    void close();
+
+    // Start over at the first point
+    bool rewind();
+
+    // Read up to capacity points, fewer only at the end of the input or after an error
+    size_t read(real *x, real *y, size_t capacity);
+
+    bool failed() const { return error; }
+
+private:
+    size_t readBinary(real *x, real *y, size_t capacity);
+    size_t readText(real *x, real *y, size_t capacity);
+
+    FILE *file;
+    PointFormat format;
+    PointType type;
+    PointLayout layout;
+    uint64_t count, position, dataOffset;
+
+    // Raw bytes of a block, or text after the last complete line; text points parsed but not
+    // yet returned
+    std::vector<char> buffer;
+    std::vector<real> pendingX, pendingY;
+    size_t pending;
+    bool atEnd, error;
+};
+
+// Write points in the header format
+bool savePoints(const std::string &filename, const real *x, const real *y, size_t count,
+                PointType type = POINT_F64, PointLayout layout = LAYOUT_PLANAR);
+
+#endif // POINTIO_H
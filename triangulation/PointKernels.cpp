@@ -0,0 +1,252 @@
+#include "PointKernels.h"
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POINT_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(real) == sizeof(double), "SIMD point kernels are written for double coordinates");
+
+namespace {
+
+// Vector versions of pseudoAngleKey()
+const double KEY_SCALE = 2147483648.0;
+const double KEY_MAX = 4294967295.0;
+
+inline real at(const real *v, const int *idx, size_t i)
+{
+    return idx ? v[idx[i]] : v[i];
+}
+
+// Scalar versions, also used for the tails of the vector loops
+
+size_t lowestFrom(const real *x, const real *y, const int *idx, size_t begin, size_t count, size_t best)
+{
+    real best_x = at(x, idx, best), best_y = at(y, idx, best);
+    for (size_t i = begin; i < count; ++i) {
+        real xi = at(x, idx, i), yi = at(y, idx, i);
+        if (yi < best_y || (yi == best_y && xi < best_x)) {
+            best = i; best_x = xi; best_y = yi;
+        }
+    }
+    return best;
+}
+
+void angleKeysFrom(const real *x, const real *y, const int *idx, size_t begin, size_t count,
+                   real ox, real oy, uint64_t *out)
+{
+    for (size_t i = begin; i < count; ++i)
+        out[i] = (uint64_t(pseudoAngleKey(at(x, idx, i) - ox, at(y, idx, i) - oy)) << 32) | uint32_t(i);
+}
+
+size_t lowestScalar(const real *x, const real *y, const int *idx, size_t count)
+{
+    return count == 0 ? 0 : lowestFrom(x, y, idx, 1, count, 0);
+}
+
+void angleKeysScalar(const real *x, const real *y, const int *idx, size_t count,
+                     real ox, real oy, uint64_t *out)
+{
+    angleKeysFrom(x, y, idx, 0, count, ox, oy, out);
+}
+
+// Reduce per-lane candidates (first, second, index) to the lexicographic minimum
+size_t reduceLanes(const double *first, const double *second, const double *index, int lanes)
+{
+    int best = 0;
+    for (int lane = 1; lane < lanes; ++lane) {
+        if (first[lane] < first[best] || (first[lane] == first[best] &&
+            (second[lane] < second[best] || (second[lane] == second[best] && index[lane] < index[best]))))
+            best = lane;
+    }
+    return size_t(index[best]);
+}
+
+#ifdef POINT_KERNELS_X86
+
+// AVX-512 implies FMA, keep GCC from fusing the products so that every level rounds alike
+#if !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// AVX2 versions, four points per step
+
+__attribute__((target("avx2")))
+inline __m256d load4(const real *v, const int *idx, size_t i)
+{
+    // Masked form with a zero source, the plain one leaves GCC warning of an uninitialized source
+    if (idx)
+        return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), v, _mm_loadu_si128((const __m128i*)(idx + i)),
+                                        _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+    return _mm256_loadu_pd(v + i);
+}
+
+__attribute__((target("avx2")))
+size_t lowestAvx2(const real *x, const real *y, const int *idx, size_t count)
+{
+    if (count < 8)
+        return lowestScalar(x, y, idx, count);
+
+    size_t vector_end = count & ~size_t(3);
+    __m256d best_x = load4(x, idx, 0), best_y = load4(y, idx, 0);
+    __m256d best_i = _mm256_setr_pd(0, 1, 2, 3), step = _mm256_set1_pd(4), index = best_i;
+
+    for (size_t i = 4; i < vector_end; i += 4) {
+        index = _mm256_add_pd(index, step);
+        __m256d vx = load4(x, idx, i), vy = load4(y, idx, i);
+        __m256d less = _mm256_or_pd(_mm256_cmp_pd(vy, best_y, _CMP_LT_OQ),
+                                    _mm256_and_pd(_mm256_cmp_pd(vy, best_y, _CMP_EQ_OQ),
+                                                  _mm256_cmp_pd(vx, best_x, _CMP_LT_OQ)));
+        best_x = _mm256_blendv_pd(best_x, vx, less);
+        best_y = _mm256_blendv_pd(best_y, vy, less);
+        best_i = _mm256_blendv_pd(best_i, index, less);
+    }
+
+    alignas(32) double lane_x[4], lane_y[4], lane_i[4];
+    _mm256_store_pd(lane_x, best_x);
+    _mm256_store_pd(lane_y, best_y);
+    _mm256_store_pd(lane_i, best_i);
+    return lowestFrom(x, y, idx, vector_end, count, reduceLanes(lane_y, lane_x, lane_i, 4));
+}
+
+__attribute__((target("avx2")))
+void angleKeysAvx2(const real *x, const real *y, const int *idx, size_t count,
+                   real ox, real oy, uint64_t *out)
+{
+    size_t vector_end = count & ~size_t(3);
+    __m256d vox = _mm256_set1_pd(ox), voy = _mm256_set1_pd(oy);
+    __m256d sign = _mm256_set1_pd(-0.0), one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd();
+    __m256d scale = _mm256_set1_pd(KEY_SCALE), bias = _mm256_set1_pd(KEY_SCALE), top = _mm256_set1_pd(KEY_MAX);
+    __m128i flip = _mm_set1_epi32(int(0x80000000u));
+    __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+
+    for (size_t i = 0; i < vector_end; i += 4) {
+        __m256d dx = _mm256_sub_pd(load4(x, idx, i), vox), dy = _mm256_sub_pd(load4(y, idx, i), voy);
+        __m256d sum = _mm256_add_pd(_mm256_andnot_pd(sign, dx), _mm256_andnot_pd(sign, dy));
+        __m256d key = _mm256_floor_pd(_mm256_mul_pd(_mm256_sub_pd(one, _mm256_div_pd(dx, sum)), scale));
+        key = _mm256_min_pd(_mm256_blendv_pd(key, zero, _mm256_cmp_pd(sum, zero, _CMP_EQ_OQ)), top);
+
+        // Unsigned conversion through the signed one, shifted by 2^31
+        __m128i key32 = _mm_xor_si128(_mm256_cvttpd_epi32(_mm256_sub_pd(key, bias)), flip);
+        __m128i index = _mm_add_epi32(lanes, _mm_set1_epi32(int(i)));
+        __m256i item = _mm256_or_si256(_mm256_slli_epi64(_mm256_cvtepu32_epi64(key32), 32),
+                                       _mm256_cvtepu32_epi64(index));
+        _mm256_storeu_si256((__m256i*)(out + i), item);
+    }
+    angleKeysFrom(x, y, idx, vector_end, count, ox, oy, out);
+}
+
+// AVX-512 versions, eight points per step
+
+__attribute__((target("avx512f")))
+inline __m512d load8(const real *v, const int *idx, size_t i)
+{
+    if (idx)
+        return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, _mm256_loadu_si256((const __m256i*)(idx + i)), v, 8);
+    return _mm512_loadu_pd(v + i);
+}
+
+__attribute__((target("avx512f")))
+size_t lowestAvx512(const real *x, const real *y, const int *idx, size_t count)
+{
+    if (count < 16)
+        return lowestScalar(x, y, idx, count);
+
+    size_t vector_end = count & ~size_t(7);
+    __m512d best_x = load8(x, idx, 0), best_y = load8(y, idx, 0);
+    __m512d best_i = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7), step = _mm512_set1_pd(8), index = best_i;
+
+    for (size_t i = 8; i < vector_end; i += 8) {
+        index = _mm512_add_pd(index, step);
+        __m512d vx = load8(x, idx, i), vy = load8(y, idx, i);
+        __mmask8 less = _mm512_cmp_pd_mask(vy, best_y, _CMP_LT_OQ) |
+                        (_mm512_cmp_pd_mask(vy, best_y, _CMP_EQ_OQ) & _mm512_cmp_pd_mask(vx, best_x, _CMP_LT_OQ));
+        best_x = _mm512_mask_blend_pd(less, best_x, vx);
+        best_y = _mm512_mask_blend_pd(less, best_y, vy);
+        best_i = _mm512_mask_blend_pd(less, best_i, index);
+    }
+
+    alignas(64) double lane_x[8], lane_y[8], lane_i[8];
+    _mm512_store_pd(lane_x, best_x);
+    _mm512_store_pd(lane_y, best_y);
+    _mm512_store_pd(lane_i, best_i);
+    return lowestFrom(x, y, idx, vector_end, count, reduceLanes(lane_y, lane_x, lane_i, 8));
+}
+
+__attribute__((target("avx512f")))
+void angleKeysAvx512(const real *x, const real *y, const int *idx, size_t count,
+                     real ox, real oy, uint64_t *out)
+{
+    size_t vector_end = count & ~size_t(7);
+    __m512d vox = _mm512_set1_pd(ox), voy = _mm512_set1_pd(oy);
+    __m512d one = _mm512_set1_pd(1.0), zero = _mm512_setzero_pd();
+    __m512d scale = _mm512_set1_pd(KEY_SCALE), top = _mm512_set1_pd(KEY_MAX);
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    // Zero-masked forms with all lanes set, the plain ones leave GCC warning of an uninitialized source
+    const __mmask8 all = 0xFF;
+
+    for (size_t i = 0; i < vector_end; i += 8) {
+        __m512d dx = _mm512_sub_pd(load8(x, idx, i), vox), dy = _mm512_sub_pd(load8(y, idx, i), voy);
+        __m512d sum = _mm512_add_pd(_mm512_abs_pd(dx), _mm512_abs_pd(dy));
+        __m512d key = _mm512_mul_pd(_mm512_sub_pd(one, _mm512_div_pd(dx, sum)), scale);
+        key = _mm512_maskz_roundscale_pd(all, key, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        key = _mm512_maskz_min_pd(all, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(sum, zero, _CMP_EQ_OQ), key, zero), top);
+
+        __m256i index = _mm256_add_epi32(lanes, _mm256_set1_epi32(int(i)));
+        __m512i keys = _mm512_maskz_cvtepu32_epi64(all, _mm512_maskz_cvttpd_epu32(all, key));
+        __m512i item = _mm512_or_si512(_mm512_maskz_slli_epi64(all, keys, 32), _mm512_maskz_cvtepu32_epi64(all, index));
+        _mm512_storeu_si512((void*)(out + i), item);
+    }
+    angleKeysFrom(x, y, idx, vector_end, count, ox, oy, out);
+}
+
+#if !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+#endif // POINT_KERNELS_X86
+
+const PointKernels SCALAR_KERNELS = { SIMD_SCALAR, lowestScalar, angleKeysScalar };
+#ifdef POINT_KERNELS_X86
+const PointKernels AVX2_KERNELS = { SIMD_AVX2, lowestAvx2, angleKeysAvx2 };
+const PointKernels AVX512_KERNELS = { SIMD_AVX512, lowestAvx512, angleKeysAvx512 };
+#endif
+
+SimdLevel detectLevel()
+{
+#ifdef POINT_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+#endif
+    return SIMD_SCALAR;
+}
+
+}
+
+const PointKernels &pointKernels()
+{
+    static const SimdLevel level = detectLevel();
+    return pointKernels(level);
+}
+
+const PointKernels &pointKernels(SimdLevel level)
+{
+    static const SimdLevel available = detectLevel();
+    if (level > available)
+        level = available;
+
+#ifdef POINT_KERNELS_X86
+    if (level == SIMD_AVX512)
+        return AVX512_KERNELS;
+    if (level == SIMD_AVX2)
+        return AVX2_KERNELS;
+#endif
+    return SCALAR_KERNELS;
+}
@@ -0,0 +1,47 @@
+#ifndef POINTKERNELS_H
+#define POINTKERNELS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "Defs.h"
+
+enum SimdLevel
+{
+    SIMD_SCALAR,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+// Bulk kernels over structure-of-arrays coordinates. Every kernel visits the points
+// idx[0..count) of the x and y arrays, or the first count points when idx is null.
+struct PointKernels
+{
+    SimdLevel level;
+
+    // Position of the lowest point by y, then by x (first one on ties)
+    size_t (*lowest)(const real *x, const real *y, const int *idx, size_t count);
+
+    // out[i] = pseudo-angle key of p_i around (ox, oy) in the upper 32 bits, i in the lower ones.
+    // All points must lie on or above the origin.
+    void (*angleKeys)(const real *x, const real *y, const int *idx, size_t count,
+                      real ox, real oy, uint64_t *out);
+};
+
+// Pseudo-angle of (dx, dy) on the upper half-plane scaled from [0, 2) to the full 32-bit range
+inline uint32_t pseudoAngleKey(real dx, real dy)
+{
+    const real scale = 2147483648.0, top = 4294967295.0;
+    real sum = std::fabs(dx) + std::fabs(dy);
+    real key = sum == 0.0 ? 0.0 : std::floor((1.0 - dx / sum) * scale);
+    return key < top ? uint32_t(key) : 0xFFFFFFFFu;
+}
+
+// Best kernels supported by this CPU, detected on the first call
+const PointKernels &pointKernels();
+
+// Kernels of the given level, or the best available one below it
+const PointKernels &pointKernels(SimdLevel level);
+
+#endif // POINTKERNELS_H
@@ -0,0 +1,230 @@
+#include "PointLocation.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+
+// Below this many queries sorting them costs more than it saves
+const size_t SORT_MIN_QUERIES = 256;
+
+// Queries per block handed to a worker
+const size_t BLOCK_QUERIES = 4096;
+
+// Steps of a walk before it is given up, from the previous triangle and from the layer vertex.
+// The visibility walk may circle in triangulations that are not Delaunay, then every triangle
+// is tested.
+const size_t NEAR_WALK_STEPS = 64;
+const size_t FAR_WALK_STEPS = 4096;
+
+template <typename Coord>
+inline real side(const BasicPointArray<Coord> &points, size_t a, size_t b, real qx, real qy)
+{
+    return orient2d(real(points.x[a]), real(points.y[a]), real(points.x[b]), real(points.y[b]), qx, qy);
+}
+
+// True if (qx, qy) lies in the counterclockwise convex layer or on its boundary. Layers of fewer
+// than three points hold nothing.
+template <typename Coord, typename Layer>
+bool layerContains(const BasicPointArray<Coord> &points, const Layer &layer, real qx, real qy)
+{
+    size_t size = layer.size();
+    if (size < 3)
+        return false;
+    size_t first = layer[0];
+    if (side(points, first, layer[1], qx, qy) < 0 || side(points, first, layer[size - 1], qx, qy) > 0)
+        return false;
+
+    size_t low = 1, high = size - 1;
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (side(points, first, layer[middle], qx, qy) > 0)
+            low = middle;
+        else
+            high = middle;
+    }
+    return side(points, layer[low], layer[high], qx, qy) >= 0;
+}
+
+template <typename Coord, typename Index>
+class Locator
+{
+public:
+    Locator(const BasicPointArray<Coord> &points, const LayerList<Index> &layers,
+            const BasicTriangleMesh<Index> &mesh, const LocationIndex<Index> &index) :
+        points(points), layers(layers), mesh(mesh), index(index) {}
+
+    // Triangle of (qx, qy), trying the walk from previous first
+    Index locate(real qx, real qy, Index previous) const {
+        bool outside = false;
+        if (previous != NONE) {
+            Index triangle = walk(previous, qx, qy, NEAR_WALK_STEPS, outside);
+            if (triangle != NONE || outside)
+                return triangle;
+        }
+
+        Index start = layerTriangle(qx, qy, outside);
+        if (outside)
+            return NONE;
+        if (start != NONE) {
+            Index triangle = walk(start, qx, qy, FAR_WALK_STEPS, outside);
+            if (triangle != NONE || outside)
+                return triangle;
+        }
+        return scan(qx, qy);
+    }
+
+private:
+    static constexpr Index NONE = BasicTriangleMesh<Index>::NONE;
+
+    real side(size_t a, size_t b, real qx, real qy) const { return ::side(points, a, b, qx, qy); }
+
+    // Triangle of the vertex of the deepest layer holding the query in its direction, NONE if
+    // no layer of three or more points holds it, outside if not even the outermost one does
+    Index layerTriangle(real qx, real qy, bool &outside) const {
+        size_t low = 0, high = layers.size();
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (layerContains(points, layers[middle], qx, qy))
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low == 0) {
+            // Only a hull of three or more points has an inside
+            outside = layers.size() > 0 && layers[0].size() >= 3;
+            return NONE;
+        }
+
+        // Last vertex at or before the query counterclockwise around the center, counting from the
+        // first vertex: the half-plane left of the first direction comes before the right one
+        typename LayerList<Index>::Layer layer = layers[low - 1];
+        real cx = index.centers[2 * (low - 1)], cy = index.centers[2 * (low - 1) + 1];
+        real x0 = real(points.x[layer[0]]), y0 = real(points.y[layer[0]]);
+        bool query_right = orient2d(cx, cy, x0, y0, qx, qy) < 0;
+        size_t first = 0, last = layer.size() - 1;
+        while (first < last) {
+            size_t middle = (first + last + 1) / 2;
+            real vx = real(points.x[layer[middle]]), vy = real(points.y[layer[middle]]);
+            bool vertex_right = orient2d(cx, cy, x0, y0, vx, vy) < 0;
+            if (vertex_right < query_right || (vertex_right == query_right && orient2d(cx, cy, vx, vy, qx, qy) >= 0))
+                first = middle;
+            else
+                last = middle - 1;
+        }
+        return index.vertexTriangles[layer[first]];
+    }
+
+    // Visibility walk: cross any edge the query lies strictly right of. A hull edge ends it with
+    // outside set, as the hull is convex.
+    Index walk(Index triangle, real qx, real qy, size_t steps, bool &outside) const {
+        Index came = NONE;
+        for (size_t step = 0; step < steps; ++step) {
+            size_t base = 3 * size_t(triangle);
+            Index next = NONE;
+            for (size_t j = 0; j < 3; ++j) {
+                size_t edge = base + (j + step) % 3;
+                Index neighbor = mesh.neighbors[edge];
+                if (neighbor != NONE && neighbor == came)
+                    continue;
+                if (side(mesh.triangles[edge], mesh.triangles[mesh.next(Index(edge))], qx, qy) < 0) {
+                    if (neighbor == NONE) {
+                        outside = true;
+                        return NONE;
+                    }
+                    next = neighbor;
+                    break;
+                }
+            }
+            if (next == NONE)
+                return triangle;
+            came = triangle;
+            triangle = next;
+        }
+        return NONE;
+    }
+
+    Index scan(real qx, real qy) const {
+        for (size_t t = 0; t < mesh.size(); ++t) {
+            if (side(mesh.triangles[3 * t], mesh.triangles[3 * t + 1], qx, qy) >= 0 &&
+                side(mesh.triangles[3 * t + 1], mesh.triangles[3 * t + 2], qx, qy) >= 0 &&
+                side(mesh.triangles[3 * t + 2], mesh.triangles[3 * t], qx, qy) >= 0)
+                return Index(t);
+        }
+        return NONE;
+    }
+
+    const BasicPointArray<Coord> &points;
+    const LayerList<Index> &layers;
+    const BasicTriangleMesh<Index> &mesh;
+    const LocationIndex<Index> &index;
+};
+
+}
+
+template <typename Coord, typename Index>
+void buildLocationIndex(const BasicPointArray<Coord> &points, const LayerList<Index> &layers,
+                        const BasicTriangleMesh<Index> &mesh, LocationIndex<Index> &index, ThreadPool *pool)
+{
+    index.centers.resize(2 * layers.size());
+    runTasks(pool, layers.size(), [&](size_t layer_i, unsigned) {
+        real sum_x = 0, sum_y = 0;
+        for (Index point : layers[layer_i]) {
+            sum_x += real(points.x[point]);
+            sum_y += real(points.y[point]);
+        }
+        size_t size = layers[layer_i].size();
+        index.centers[2 * layer_i] = size ? sum_x / real(size) : 0;
+        index.centers[2 * layer_i + 1] = size ? sum_y / real(size) : 0;
+    });
+
+    index.vertexTriangles.assign(points.size(), mesh.NONE);
+    for (size_t corner = 0; corner < mesh.triangles.size(); ++corner)
+        index.vertexTriangles[mesh.triangles[corner]] = Index(corner / 3);
+}
+
+template <typename Coord, typename Index>
+void locatePoints(const BasicPointArray<Coord> &points, const LayerList<Index> &layers,
+                  const BasicTriangleMesh<Index> &mesh, const LocationIndex<Index> &index,
+                  const BasicPointArray<real> &queries, Index *triangles, std::vector<Index> &order,
+                  MeshOrderBuffers<Index> &buffers, ThreadPool *pool)
+{
+    const Index NONE = mesh.NONE;
+    size_t count = queries.size();
+    if (mesh.triangles.empty() || mesh.neighbors.empty()) {
+        std::fill(triangles, triangles + count, NONE);
+        return;
+    }
+
+    // Queries close on the curve are close in the mesh, so the walks from one to the next are short
+    if (count >= SORT_MIN_QUERIES) {
+        curveOrder(queries, MESH_ORDER_HILBERT, order, buffers, pool);
+    } else {
+        order.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            order[i] = Index(i);
+    }
+
+    Locator<Coord, Index> locator(points, layers, mesh, index);
+    size_t blocks = (count + BLOCK_QUERIES - 1) / BLOCK_QUERIES;
+    runTasks(pool, blocks, [&](size_t block, unsigned) {
+        size_t end = std::min(count, (block + 1) * BLOCK_QUERIES);
+        Index previous = NONE;
+        for (size_t i = block * BLOCK_QUERIES; i < end; ++i) {
+            size_t query = size_t(order[i]);
+            Index triangle = locator.locate(queries.x[query], queries.y[query], previous);
+            triangles[query] = triangle;
+            if (triangle != NONE)
+                previous = triangle;
+        }
+    });
+}
+
+#define INSTANTIATE_POINT_LOCATION(Coord, Index) \
+    template void buildLocationIndex(const BasicPointArray<Coord>&, const LayerList<Index>&, \
+                                     const BasicTriangleMesh<Index>&, LocationIndex<Index>&, ThreadPool*); \
+    template void locatePoints(const BasicPointArray<Coord>&, const LayerList<Index>&, const BasicTriangleMesh<Index>&, \
+                               const LocationIndex<Index>&, const BasicPointArray<real>&, Index*, std::vector<Index>&, \
+                               MeshOrderBuffers<Index>&, ThreadPool*);
+
+FOR_EACH_COORDINATE_AND_INDEX(INSTANTIATE_POINT_LOCATION)
@@ -0,0 +1,47 @@
+#ifndef POINTLOCATION_H
+#define POINTLOCATION_H
+
+#include <vector>
+
+#include "LayerList.h"
+#include "MeshOrder.h"
+#include "PointArray.h"
+#include "TriangleMesh.h"
+
+class ThreadPool;
+
+// Point location in a layer triangulation. The layers are nested convex polygons, so a binary
+// search over them with O(log h) containment tests finds the deepest layer holding a query. The
+// vertex of that layer in the direction of the query, seen from the layer's center, starts a
+// walk through the triangles, which mostly ends in the strip just inside the layer.
+template <typename Index>
+struct LocationIndex
+{
+    // Vertex average of every layer, x and y interleaved
+    std::vector<real> centers;
+
+    // One triangle of every point, NONE for points of no triangle
+    std::vector<Index> vertexTriangles;
+
+    bool empty() const { return vertexTriangles.empty(); }
+
+    void clear() {
+        centers.clear();
+        vertexTriangles.clear();
+    }
+};
+
+template <typename Coord, typename Index>
+void buildLocationIndex(const BasicPointArray<Coord> &points, const LayerList<Index> &layers,
+                        const BasicTriangleMesh<Index> &mesh, LocationIndex<Index> &index, ThreadPool *pool);
+
+// Triangle holding every query point, any of them for points on edges, NONE outside the hull or
+// without triangles. The queries are taken in Hilbert order and split into blocks for the pool;
+// within a block every walk starts from the triangle of the query before.
+template <typename Coord, typename Index>
+void locatePoints(const BasicPointArray<Coord> &points, const LayerList<Index> &layers,
+                  const BasicTriangleMesh<Index> &mesh, const LocationIndex<Index> &index,
+                  const BasicPointArray<real> &queries, Index *triangles, std::vector<Index> &order,
+                  MeshOrderBuffers<Index> &buffers, ThreadPool *pool);
+
+#endif // POINTLOCATION_H
@@ -0,0 +1,210 @@
+#include "Predicates.h"
+
+#include <cmath>
+
+// The error-free transformations below rely on every operation being rounded on its own
+#if !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace {
+
+// a + b = x + y exactly
+inline void twoSum(real a, real b, real &x, real &y)
+{
+    x = a + b;
+    real bv = x - a, av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+// a + b = x + y exactly, requires |a| >= |b|
+inline void fastTwoSum(real a, real b, real &x, real &y)
+{
+    x = a + b;
+    y = b - (x - a);
+}
+
+// a * b = x + y exactly
+inline void twoProduct(real a, real b, real &x, real &y)
+{
+    x = a * b;
+#ifdef __FMA__
+    y = std::fma(a, b, -x);
+#else
+    // Dekker's product with the factors split into halves of 26 bits
+    const real splitter = 134217729.0;
+    real c = splitter * a, ahi = c - (c - a), alo = a - ahi;
+    c = splitter * b;
+    real bhi = c - (c - b), blo = b - bhi;
+    y = alo * blo - (((x - ahi * bhi) - alo * bhi) - ahi * blo);
+#endif
+}
+
+// Exact value as a sum of nonoverlapping components ordered by increasing magnitude, zero
+// components are dropped. Capacity bounds the components: a sum has at most those of its parts
+// together and a product of expansions with m and n components at most 2mn, so every value
+// below gets the capacity of the way it is built.
+template <int Capacity>
+struct Expansion
+{
+    real terms[Capacity];
+    int size;
+
+    Expansion() : size(0) {}
+
+    // this += b
+    void add(real b) {
+        real q = b, sum, h;
+        int out = 0;
+        for (int i = 0; i < size; ++i) {
+            twoSum(q, terms[i], sum, h);
+            q = sum;
+            if (h != 0.0)
+                terms[out++] = h;
+        }
+        if (q != 0.0 || out == 0)
+            terms[out++] = q;
+        size = out;
+    }
+
+    template <int Other>
+    void add(const Expansion<Other> &e) {
+        for (int i = 0; i < e.size; ++i)
+            add(e.terms[i]);
+    }
+
+    void negate() {
+        for (int i = 0; i < size; ++i)
+            terms[i] = -terms[i];
+    }
+
+    // this = e * b
+    template <int Other>
+    void scale(const Expansion<Other> &e, real b) {
+        static_assert(Capacity >= 2 * Other, "Expansion too small for the product");
+        real q, h, product1, product0, sum;
+        size = 0;
+        if (e.size == 0)
+            return;
+        twoProduct(e.terms[0], b, q, h);
+        if (h != 0.0)
+            terms[size++] = h;
+        for (int i = 1; i < e.size; ++i) {
+            twoProduct(e.terms[i], b, product1, product0);
+            twoSum(q, product0, sum, h);
+            if (h != 0.0)
+                terms[size++] = h;
+            fastTwoSum(product1, sum, q, h);
+            if (h != 0.0)
+                terms[size++] = h;
+        }
+        if (q != 0.0 || size == 0)
+            terms[size++] = q;
+    }
+
+    // this = e * f
+    template <int E, int F>
+    void multiply(const Expansion<E> &e, const Expansion<F> &f) {
+        static_assert(Capacity >= 2 * E * F, "Expansion too small for the product");
+        Expansion<2 * E> part;
+        size = 0;
+        for (int i = 0; i < f.size; ++i) {
+            part.scale(e, f.terms[i]);
+            add(part);
+        }
+    }
+
+    int sign() const {
+        real top = size ? terms[size - 1] : 0.0;
+        return (top > 0.0) - (top < 0.0);
+    }
+
+    // The largest component dominates the sum, so the sign of the estimate is exact
+    real estimate() const {
+        real sum = 0.0;
+        for (int i = 0; i < size; ++i)
+            sum += terms[i];
+        return sum;
+    }
+};
+
+typedef Expansion<2> Difference;
+typedef Expansion<16> Quadratic;
+
+Difference difference(real a, real b)
+{
+    Difference e;
+    e.add(a);
+    e.add(-b);
+    return e;
+}
+
+// a * a + b * b
+Quadratic squaredLength(const Difference &a, const Difference &b)
+{
+    Quadratic square;
+    Expansion<8> other;
+    square.multiply(a, a);
+    other.multiply(b, b);
+    square.add(other);
+    return square;
+}
+
+// (a1 - a2) * (b1 - b2) - (c1 - c2) * (d1 - d2)
+Quadratic determinant(const Difference &a, const Difference &b, const Difference &c, const Difference &d)
+{
+    Quadratic left;
+    Expansion<8> right;
+    left.multiply(a, b);
+    right.multiply(c, d);
+    right.negate();
+    left.add(right);
+    return left;
+}
+
+}
+
+real orient2dExact(real ax, real ay, real bx, real by, real cx, real cy)
+{
+    Quadratic det = determinant(difference(ax, cx), difference(by, cy),
+                                difference(ay, cy), difference(bx, cx));
+    return det.estimate();
+}
+
+// Three products of quadratics with 16 components, 512 each
+real incircleExact(real ax, real ay, real bx, real by, real cx, real cy, real dx, real dy)
+{
+    Difference adx = difference(ax, dx), ady = difference(ay, dy);
+    Difference bdx = difference(bx, dx), bdy = difference(by, dy);
+    Difference cdx = difference(cx, dx), cdy = difference(cy, dy);
+
+    Expansion<3 * 512> det;
+    Expansion<512> term;
+    det.multiply(squaredLength(adx, ady), determinant(bdx, cdy, cdx, bdy));
+    term.multiply(squaredLength(bdx, bdy), determinant(cdx, ady, adx, cdy));
+    det.add(term);
+    term.multiply(squaredLength(cdx, cdy), determinant(adx, bdy, bdx, ady));
+    det.add(term);
+    return det.estimate();
+}
+
+bool intersectsLeftOfExact(real ax, real ay, real bx, real by, real cx, real cy, real dx, real dy, real split)
+{
+    Difference edx1 = difference(bx, ax), edy1 = difference(by, ay);
+    Difference edx2 = difference(dx, cx), edy2 = difference(dy, cy);
+    Quadratic exact_denom = determinant(edx1, edy2, edy1, edx2);
+    if (exact_denom.sign() == 0)
+        return true;
+
+    // Two products of a quadratic and a difference, 64 components each
+    Quadratic exact_numer = determinant(difference(cx, ax), edy2, difference(cy, ay), edx2);
+    Expansion<2 * 64> exact_side;
+    Expansion<64> scaled;
+    exact_side.multiply(exact_numer, edx1);
+    scaled.multiply(difference(split, ax), exact_denom);
+    scaled.negate();
+    exact_side.add(scaled);
+
+    int sign = exact_side.sign();
+    return sign != 0 && (sign < 0) == (exact_denom.sign() > 0);
+}
@@ -0,0 +1,104 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include <cmath>
+
+#include "Defs.h"
+
+// Geometric predicates with exact signs (Shewchuk, Adaptive Precision Floating-Point Arithmetic
+// and Fast Robust Geometric Predicates). The rounded determinant is checked against an error
+// bound first; only when it is too close to zero to trust is it recomputed with floating-point
+// expansions, which is rare on anything but degenerate input. Underflow and overflow are ignored.
+
+// Half the distance from 1 to the next double, the relative rounding error
+const real ROUNDING_ERROR = 1.1102230246251565e-16;
+
+// Error bound of the rounded 2x2 orientation determinant, relative to its permanent
+const real ORIENT_ERROR_BOUND = (3.0 + 16.0 * ROUNDING_ERROR) * ROUNDING_ERROR;
+
+// Exact recomputation of orient2d, called when the filter fails
+real orient2dExact(real ax, real ay, real bx, real by, real cx, real cy);
+
+// Twice the signed area of the triangle (a, b, c): positive if counterclockwise, negative if
+// clockwise and zero if the points are collinear. The sign is exact, the value an approximation.
+inline real orient2d(real ax, real ay, real bx, real by, real cx, real cy)
+{
+    real left = (ax - cx) * (by - cy);
+    real right = (ay - cy) * (bx - cx);
+    real det = left - right;
+
+    real sum;
+    if (left > 0.0) {
+        if (right <= 0.0)
+            return det;
+        sum = left + right;
+    } else if (left < 0.0) {
+        if (right >= 0.0)
+            return det;
+        sum = -left - right;
+    } else {
+        return det;
+    }
+
+    real bound = ORIENT_ERROR_BOUND * sum;
+    if (det >= bound || -det >= bound)
+        return det;
+    return orient2dExact(ax, ay, bx, by, cx, cy);
+}
+
+// Error bound of the rounded incircle determinant, relative to its permanent
+const real INCIRCLE_ERROR_BOUND = (10.0 + 96.0 * ROUNDING_ERROR) * ROUNDING_ERROR;
+
+// Exact recomputation of incircle, called when the filter fails
+real incircleExact(real ax, real ay, real bx, real by, real cx, real cy, real dx, real dy);
+
+// Positive if d lies inside the circle through the counterclockwise triangle (a, b, c), negative
+// if outside and zero if on it. The sign is exact, the value an approximation.
+inline real incircle(real ax, real ay, real bx, real by, real cx, real cy, real dx, real dy)
+{
+    real adx = ax - dx, ady = ay - dy, bdx = bx - dx, bdy = by - dy, cdx = cx - dx, cdy = cy - dy;
+
+    real bdxcdy = bdx * cdy, cdxbdy = cdx * bdy, alift = adx * adx + ady * ady;
+    real cdxady = cdx * ady, adxcdy = adx * cdy, blift = bdx * bdx + bdy * bdy;
+    real adxbdy = adx * bdy, bdxady = bdx * ady, clift = cdx * cdx + cdy * cdy;
+
+    real det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    real permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * alift + (fabs(cdxady) + fabs(adxcdy)) * blift +
+                     (fabs(adxbdy) + fabs(bdxady)) * clift;
+
+    real bound = INCIRCLE_ERROR_BOUND * permanent;
+    if (det > bound || -det > bound)
+        return det;
+    return incircleExact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+// Conservative error bound of the rounded side test in intersectsLeftOf, relative to its permanent
+const real SIDE_ERROR_BOUND = (10.0 + 128.0 * ROUNDING_ERROR) * ROUNDING_ERROR;
+
+// Exact evaluation of intersectsLeftOf, called when the filter fails
+bool intersectsLeftOfExact(real ax, real ay, real bx, real by, real cx, real cy, real dx, real dy, real split);
+
+// True if the lines ab and cd meet left of the vertical line x = split. Parallel lines count as
+// meeting left of it, lines meeting on it do not.
+inline bool intersectsLeftOf(real ax, real ay, real bx, real by, real cx, real cy, real dx, real dy, real split)
+{
+    // With t = numer / denom the lines meet at a + t (b - a), left of the split line if
+    // numer * (bx - ax) - (split - ax) * denom has the opposite sign of denom
+    real dx1 = bx - ax, dy1 = by - ay, dx2 = dx - cx, dy2 = dy - cy;
+    real acx = cx - ax, acy = cy - ay, sx = split - ax;
+
+    real denom_left = dx1 * dy2, denom_right = dy1 * dx2;
+    real denom = denom_left - denom_right;
+    real denom_sum = fabs(denom_left) + fabs(denom_right);
+
+    real numer_left = acx * dy2, numer_right = acy * dx2;
+    real side = (numer_left - numer_right) * dx1 - sx * denom;
+    real side_sum = (fabs(numer_left) + fabs(numer_right)) * fabs(dx1) + fabs(sx) * denom_sum;
+
+    real denom_bound = ORIENT_ERROR_BOUND * denom_sum, side_bound = SIDE_ERROR_BOUND * side_sum;
+    if ((denom > denom_bound || -denom > denom_bound) && (side > side_bound || -side > side_bound))
+        return (side < 0.0) == (denom > 0.0);
+    return intersectsLeftOfExact(ax, ay, bx, by, cx, cy, dx, dy, split);
+}
+
+#endif // PREDICATES_H
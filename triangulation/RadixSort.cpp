@@ -0,0 +1,80 @@
+#include "RadixSort.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+
+const unsigned RADIX_BITS = 8;
+const size_t   RADIX_SIZE = size_t(1) << RADIX_BITS;
+
+}
+
+void radixSort(std::vector<uint64_t> &items, std::vector<uint64_t> &scratch, std::vector<size_t> &counts,
+               unsigned shift, unsigned bits, ThreadPool *pool)
+{
+    size_t size = items.size();
+    scratch.resize(size);
+    if (size < 2)
+        return;
+
+    size_t parts = blockCount(pool, size);
+    counts.resize(parts * RADIX_SIZE);
+
+    for (unsigned pass = 0; pass * RADIX_BITS < bits; ++pass) {
+        unsigned digit_shift = shift + pass * RADIX_BITS;
+        uint64_t digit_mask = RADIX_SIZE - 1;
+        if (bits - pass * RADIX_BITS < RADIX_BITS)
+            digit_mask = (uint64_t(1) << (bits - pass * RADIX_BITS)) - 1;
+
+        const uint64_t *src = items.data();
+        uint64_t *dst = scratch.data();
+
+        // Histogram of every block
+        auto histogram = [&](size_t part, unsigned) {
+            size_t begin, end;
+            blockRange(size, parts, part, begin, end);
+            size_t *count = &counts[part * RADIX_SIZE];
+            std::fill(count, count + RADIX_SIZE, 0);
+            for (size_t i = begin; i < end; ++i)
+                ++count[(src[i] >> digit_shift) & digit_mask];
+        };
+        if (parts > 1)
+            pool->run(parts, histogram);
+        else
+            histogram(0, 0);
+
+        // Turn counts into output offsets, digit-major then block-major to keep the sort stable
+        size_t offset = 0;
+        bool trivial = false;
+        for (size_t digit = 0; digit < RADIX_SIZE; ++digit) {
+            size_t total = 0;
+            for (size_t part = 0; part < parts; ++part) {
+                size_t count = counts[part * RADIX_SIZE + digit];
+                counts[part * RADIX_SIZE + digit] = offset;
+                offset += count;
+                total += count;
+            }
+            if (total == size)
+                trivial = true;
+        }
+
+        // Every item has the same digit, nothing to move
+        if (trivial)
+            continue;
+
+        auto scatter = [&](size_t part, unsigned) {
+            size_t begin, end;
+            blockRange(size, parts, part, begin, end);
+            size_t *offset = &counts[part * RADIX_SIZE];
+            for (size_t i = begin; i < end; ++i)
+                dst[offset[(src[i] >> digit_shift) & digit_mask]++] = src[i];
+        };
+        if (parts > 1)
+            pool->run(parts, scatter);
+        else
+            scatter(0, 0);
+
+        items.swap(scratch);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Bits of the values 0 .. count - 1, at least one
+inline unsigned valueBits(size_t count)
+{
+    unsigned bits = 1;
+    while (bits < 64 && ((count - 1) >> bits) != 0)
+        ++bits;
+    return bits;
+}
+
+// Stable LSD radix sort of items by the bit field [shift, shift + bits).
+// The remaining bits travel along as payload. scratch is resized to items.size()
+// and counts holds the digit histograms, both may be reused between calls.
+// pool may be nullptr for a single-threaded sort.
+void radixSort(std::vector<uint64_t> &items, std::vector<uint64_t> &scratch, std::vector<size_t> &counts,
+               unsigned shift, unsigned bits, ThreadPool *pool);
+
+#endif // RADIXSORT_H
@@ -0,0 +1,80 @@
+#include "Stats.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifndef TRIANGULATION_NO_STATS
+thread_local uint64_t orientationTests = 0;
+#endif
+
+TriangulationStats::TriangulationStats() :
+    duplicateTime(0), originTime(0), sortTime(0), layersTime(0), lowestTime(0), stitchTime(0), meshTime(0),
+    lastLayerTime(0), flipTime(0), totalTime(0), points(0), layerCount(0), duplicates(0), orientationTests(0), flips(0),
+    peakMemory(0)
+{
+}
+
+void TriangulationStats::clear()
+{
+    duplicateTime = originTime = sortTime = layersTime = lowestTime = stitchTime = meshTime = 0;
+    lastLayerTime = flipTime = totalTime = 0;
+    points = layerCount = duplicates = 0;
+    layerSizes.clear();
+    orientationTests = flips = 0;
+    peakMemory = 0;
+}
+
+void TriangulationStats::addLayer(size_t size)
+{
+    size_t bucket = 0;
+    while (size >> (bucket + 1))
+        ++bucket;
+    if (layerSizes.size() <= bucket)
+        layerSizes.resize(bucket + 1, 0);
+    ++layerSizes[bucket];
+}
+
+std::string TriangulationStats::toJSON() const
+{
+    char buffer[1024];
+    snprintf(buffer, sizeof(buffer),
+             "{\"points\": %zu, \"duplicates\": %zu, \"layers\": %zu, \"orientation_tests\": %llu, \"flips\": %llu, \"peak_memory_bytes\": %zu, "
+             "\"phases_s\": {\"duplicates\": %.9f, \"origin\": %.9f, \"sort\": %.9f, \"layers\": %.9f, \"lowest\": %.9f, \"stitch\": %.9f, "
+             "\"mesh\": %.9f, \"last_layer\": %.9f, \"flips\": %.9f, \"total\": %.9f}, \"layer_sizes\": [",
+             points, duplicates, layerCount, (unsigned long long)orientationTests, (unsigned long long)flips, peakMemory,
+             duplicateTime, originTime, sortTime, layersTime, lowestTime, stitchTime, meshTime, lastLayerTime, flipTime, totalTime);
+
+    std::string json = buffer;
+    for (size_t bucket = 0; bucket < layerSizes.size(); ++bucket) {
+        snprintf(buffer, sizeof(buffer), "%s{\"min\": %zu, \"max\": %zu, \"count\": %zu}", bucket ? ", " : "",
+                 size_t(1) << bucket, (size_t(2) << bucket) - 1, layerSizes[bucket]);
+        json += buffer;
+    }
+    json += "]}";
+    return json;
+}
+
+size_t peakMemoryUsage()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return size_t(usage.ru_maxrss);
+#else
+    return size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,89 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Timer.h"
+
+// Instrumentation of the triangulation. Define TRIANGULATION_NO_STATS to compile it out,
+// the stats are all zero then.
+
+#ifndef TRIANGULATION_NO_STATS
+
+// Orientation tests done by the calling thread so far
+extern thread_local uint64_t orientationTests;
+
+inline void countOrientationTest() { ++orientationTests; }
+inline uint64_t orientationTestCount() { return orientationTests; }
+
+#else
+
+inline void countOrientationTest() {}
+inline uint64_t orientationTestCount() { return 0; }
+
+#endif
+
+struct TriangulationStats
+{
+    TriangulationStats();
+
+    // Wall time of the phases in seconds
+    double duplicateTime;   // Duplicate removal and the collinearity test
+    double originTime;      // Lowest point of the input
+    double sortTime;        // Angular sort around the origin (Graham scan engine)
+    double layersTime;      // Layer peeling, including the sort
+    double lowestTime;      // Lowest vertex of every layer
+    double stitchTime;      // Triangulation of the strips between layers
+    double meshTime;        // Triangles and adjacency
+    double lastLayerTime;   // Fan of the last layer
+    double flipTime;        // Delaunay edge flips
+    double totalTime;
+
+    size_t points;
+    size_t layerCount;
+
+    // Points merged into an earlier one by duplicate removal
+    size_t duplicates;
+
+    // layerSizes[i] counts the layers with 2^i to 2^(i + 1) - 1 vertices
+    std::vector<size_t> layerSizes;
+
+    uint64_t orientationTests;
+
+    // Edges flipped to reach the Delaunay triangulation
+    uint64_t flips;
+
+    // Peak resident memory of the process in bytes when the triangulation finished
+    size_t peakMemory;
+
+    void addLayer(size_t size);
+
+    // Zero everything for another triangulation, keeping the layer size buckets allocated
+    void clear();
+
+    std::string toJSON() const;
+};
+
+// Peak resident set size of the process in bytes, 0 where unknown
+size_t peakMemoryUsage();
+
+// Adds the wall time of its scope to a phase
+class PhaseTimer
+{
+public:
+#ifndef TRIANGULATION_NO_STATS
+    explicit PhaseTimer(double &phase) : phase(phase) {}
+    ~PhaseTimer() { phase += timer.elapsed(); }
+
+private:
+    double &phase;
+    Timer timer;
+#else
+    explicit PhaseTimer(double &) {}
+#endif
+};
+
+#endif // STATS_H
@@ -0,0 +1,82 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) :
+    task(nullptr), count(0), next(0), active(0), generation(0), stopping(false)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    workers.reserve(threads - 1);
+    for (unsigned worker = 1; worker < threads; ++worker) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, worker));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::run(size_t count, const Task &task)
+{
+    if (count == 0)
+        return;
+
+    if (workers.empty() || count == 1) {
+        for (size_t index = 0; index < count; ++index)
+            task(index, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->count = count;
+        next = 0;
+        active = (unsigned)workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    execute(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return active == 0; });
+    this->task = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned worker)
+{
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen]() { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        execute(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0)
+            finished.notify_one();
+    }
+}
+
+void ThreadPool::execute(unsigned worker)
+{
+    for (size_t index = next++; index < count; index = next++) {
+        (*task)(index, worker);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing indexed tasks. The calling thread
+// takes part in every run, so a pool of size 1 executes tasks inline.
+class ThreadPool
+{
+public:
+    typedef std::function<void(size_t, unsigned)> Task;
+
+    // threads == 0 selects the number of hardware threads
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+    // Call task(index, worker) for every index in [0, count) and wait until all are done.
+    // Indices are handed out dynamically, worker is in [0, size()).
+    void run(size_t count, const Task &task);
+
+private:
+    void workerLoop(unsigned worker);
+    void execute(unsigned worker);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+
+    const Task *task;
+    size_t count;
+    std::atomic<size_t> next;
+    unsigned active;
+    unsigned long generation;
+    bool stopping;
+};
+
+// Below this size one thread is faster than synchronizing several
+const size_t PARALLEL_MIN_ITEMS = size_t(1) << 16;
+
+// Split [0, size) into parts of nearly equal length and return the bounds of part
+inline void blockRange(size_t size, size_t parts, size_t part, size_t &begin, size_t &end)
+{
+    begin = size * part / parts;
+    end = size * (part + 1) / parts;
+}
+
+// Run the tasks on pool, or one after another on the calling thread when there is no pool.
+// Only the pool needs task wrapped in a ThreadPool::Task, which may allocate.
+template <typename Function>
+inline void runTasks(ThreadPool *pool, size_t count, const Function &task)
+{
+    if (pool) {
+        pool->run(count, task);
+    } else {
+        for (size_t index = 0; index < count; ++index)
+            task(index, 0);
+    }
+}
+
+// Blocks [0, count) is split into for the pool
+inline size_t blockCount(ThreadPool *pool, size_t count)
+{
+    return (pool && count >= PARALLEL_MIN_ITEMS) ? pool->size() : 1;
+}
+
+// Call task(part, begin, end) for every one of parts blocks of [0, count)
+template <typename Function>
+inline void forBlocks(ThreadPool *pool, size_t parts, size_t count, const Function &task)
+{
+    runTasks(parts > 1 ? pool : nullptr, parts, [&](size_t part, unsigned) {
+        size_t begin, end;
+        blockRange(count, parts, part, begin, end);
+        task(part, begin, end);
+    });
+}
+
+#endif // THREADPOOL_H
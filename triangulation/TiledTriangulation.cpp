@@ -0,0 +1,516 @@
+#include "TiledTriangulation.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include "DiagonalRules.h"
+#include "MeshIO.h"
+#include "Predicates.h"
+#include "Stats.h"
+
+TiledOptions::TiledOptions() :
+    memoryBudget(size_t(1) << 30)
+{
+}
+
+TiledStats::TiledStats() :
+    points(0), triangles(0), edges(0), slabs(0), largestSlab(0), partitionTime(0), triangulationTime(0),
+    seamTime(0), totalTime(0), peakMemory(0)
+{
+}
+
+namespace {
+
+// Memory of a slab point: coordinates and input index, layers, edges, triangles and the buffers
+// of the hull tree peel
+const size_t BYTES_PER_SLAB_POINT = 256;
+
+// Resolution of the histogram of x the slabs are cut from
+const size_t HISTOGRAM_BINS = size_t(1) << 16;
+
+// Points per block read from the input or from a slab file
+const size_t BLOCK_POINTS = size_t(1) << 16;
+
+// Slab files written by one pass over the input, more slabs take more passes
+const size_t MAX_OPEN_SLABS = 256;
+
+// Record of a slab file
+struct SlabPoint
+{
+    real x, y;
+    uint64_t index;
+};
+
+// Vertex of the hull carried from slab to slab, index into the input
+struct HullVertex
+{
+    real x, y;
+    int32_t index;
+};
+
+inline real orient(const HullVertex &a, const HullVertex &b, const HullVertex &c)
+{
+    return orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+inline real squaredDistance(const HullVertex &a, const HullVertex &b)
+{
+    real dx = a.x - b.x, dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+// Scratch files, removed when done
+struct ScratchFiles
+{
+    std::vector<std::string> names;
+
+    ~ScratchFiles() {
+        for (const std::string &name : names)
+            std::remove(name.c_str());
+    }
+};
+
+// Triangles go straight to the output, edges to a scratch file appended to it at the end
+struct MeshSink
+{
+    BufferedWriter &triangles, &edges;
+    uint64_t triangleCount, edgeCount;
+
+    MeshSink(BufferedWriter &triangles, BufferedWriter &edges) :
+        triangles(triangles), edges(edges), triangleCount(0), edgeCount(0) {}
+
+    void triangle(int32_t a, int32_t b, int32_t c) {
+        int32_t corners[3] = { a, b, c };
+        triangles.write(corners, sizeof(corners));
+        ++triangleCount;
+    }
+
+    void edge(int32_t a, int32_t b) {
+        int32_t pair[2] = { a, b };
+        edges.write(pair, sizeof(pair));
+        ++edgeCount;
+    }
+};
+
+inline size_t nextVertex(size_t i, size_t size) { return i + 1 == size ? 0 : i + 1; }
+inline size_t previousVertex(size_t i, size_t size) { return i == 0 ? size - 1 : i - 1; }
+
+// Triangulate the gap between the counterclockwise hulls left and right, which a vertical line
+// separates, and replace left by the hull of both. The lower and the upper bridge are found by
+// walking from the facing extreme points; collinear bridges end at the vertices nearest the gap,
+// whose boundary then has no collinear spikes. The gap is closed like a strip between layers: the
+// current spoke runs from the left chain, walked counterclockwise, to the right chain, walked
+// clockwise, and every step takes the next vertex of one of them.
+template <typename Rule>
+void stitchSeam(std::vector<HullVertex> &left, const std::vector<HullVertex> &right,
+                std::vector<HullVertex> &merged, MeshSink &sink)
+{
+    size_t left_size = left.size(), right_size = right.size();
+    auto left_next = [&](size_t i) { return nextVertex(i, left_size); };
+    auto left_previous = [&](size_t i) { return previousVertex(i, left_size); };
+    auto right_next = [&](size_t i) { return nextVertex(i, right_size); };
+    auto right_previous = [&](size_t i) { return previousVertex(i, right_size); };
+
+    size_t rightmost = 0, leftmost = 0;
+    for (size_t i = 1; i < left_size; ++i) {
+        if (left[i].x > left[rightmost].x || (left[i].x == left[rightmost].x && left[i].y > left[rightmost].y))
+            rightmost = i;
+    }
+    for (size_t i = 1; i < right_size; ++i) {
+        if (right[i].x < right[leftmost].x || (right[i].x == right[leftmost].x && right[i].y < right[leftmost].y))
+            leftmost = i;
+    }
+
+    // Lower bridge: both hulls on or above the line from a to b
+    size_t lower_a = rightmost, lower_b = leftmost;
+    for (bool moved = true; moved; ) {
+        moved = false;
+        while (orient(left[lower_a], right[lower_b], right[right_next(lower_b)]) < 0) {
+            lower_b = right_next(lower_b);
+            moved = true;
+        }
+        while (orient(left[lower_a], right[lower_b], left[left_previous(lower_a)]) < 0) {
+            lower_a = left_previous(lower_a);
+            moved = true;
+        }
+    }
+    for (bool moved = true; moved; ) {
+        moved = false;
+        size_t a = left_next(lower_a), b = right_previous(lower_b);
+        if (a != lower_a && orient(left[lower_a], right[lower_b], left[a]) == 0 &&
+            squaredDistance(left[a], right[lower_b]) < squaredDistance(left[lower_a], right[lower_b])) {
+            lower_a = a;
+            moved = true;
+        }
+        if (b != lower_b && orient(left[lower_a], right[lower_b], right[b]) == 0 &&
+            squaredDistance(left[lower_a], right[b]) < squaredDistance(left[lower_a], right[lower_b])) {
+            lower_b = b;
+            moved = true;
+        }
+    }
+
+    // Upper bridge: both hulls on or below the line from a to b
+    size_t upper_a = rightmost, upper_b = leftmost;
+    for (bool moved = true; moved; ) {
+        moved = false;
+        while (orient(left[upper_a], right[upper_b], right[right_previous(upper_b)]) > 0) {
+            upper_b = right_previous(upper_b);
+            moved = true;
+        }
+        while (orient(left[upper_a], right[upper_b], left[left_next(upper_a)]) > 0) {
+            upper_a = left_next(upper_a);
+            moved = true;
+        }
+    }
+    for (bool moved = true; moved; ) {
+        moved = false;
+        size_t a = left_previous(upper_a), b = right_next(upper_b);
+        if (a != upper_a && orient(left[upper_a], right[upper_b], left[a]) == 0 &&
+            squaredDistance(left[a], right[upper_b]) < squaredDistance(left[upper_a], right[upper_b])) {
+            upper_a = a;
+            moved = true;
+        }
+        if (b != upper_b && orient(left[upper_a], right[upper_b], right[b]) == 0 &&
+            squaredDistance(left[upper_a], right[b]) < squaredDistance(left[upper_a], right[upper_b])) {
+            upper_b = b;
+            moved = true;
+        }
+    }
+
+    // Bridges that coincide leave both hulls on their line. Each is a path there, listed out and
+    // back, and the hull of both is the path through the two joined by the bridge.
+    if (lower_a == upper_a && lower_b == upper_b) {
+        sink.edge(left[lower_a].index, right[lower_b].index);
+        merged.clear();
+        for (size_t i = lower_a, n = 0; n <= left_size / 2; i = left_next(i), ++n)
+            merged.push_back(left[i]);
+        std::reverse(merged.begin(), merged.end());
+        for (size_t i = lower_b, n = 0; n <= right_size / 2; i = right_next(i), ++n)
+            merged.push_back(right[i]);
+        size_t path_size = merged.size();
+        merged.reserve(2 * path_size);
+        for (size_t i = path_size - 2; i > 0; --i)
+            merged.push_back(merged[i]);
+        left.swap(merged);
+        return;
+    }
+
+    // A hull both bridges meet at one vertex lies in the angle between them, so the whole of it
+    // faces the gap and only that vertex stays on the hull of both
+    size_t left_steps = lower_a != upper_a ? (upper_a + left_size - lower_a) % left_size : left_size - (left_size == 1);
+    size_t right_steps = lower_b != upper_b ? (lower_b + right_size - upper_b) % right_size : right_size - (right_size == 1);
+
+    // Walk the gap from the lower bridge up. A step is possible if its triangle is counterclockwise,
+    // its new spoke leaves the other hull outside the angle at its vertex and the triangle does not
+    // hold the next vertex of the other chain.
+    size_t a = lower_a, b = lower_b;
+    sink.edge(left[a].index, right[b].index);
+    while (left_steps > 0 || right_steps > 0) {
+        size_t a1 = left_next(a), b1 = right_previous(b);
+        const HullVertex &p0 = left[a], &q0 = right[b], &p1 = left[a1], &q1 = right[b1];
+        const HullVertex &p2 = left[left_previous(a)], &q2 = right[right_next(b)];
+
+        bool right_step = right_steps > 0 && orient(p0, q0, q1) > 0 &&
+            !(orient(p2, p0, q1) > 0 && orient(p0, p1, q1) > 0) &&
+            !(left_steps > 0 && orient(q0, q1, p1) > 0 && orient(q1, p0, p1) > 0 && orient(p0, q0, p1) > 0);
+        bool left_step = left_steps > 0 && orient(p0, q0, p1) > 0 &&
+            !(orient(q1, q0, p1) > 0 && orient(q0, q2, p1) > 0) &&
+            !(right_steps > 0 && orient(p0, q0, q1) > 0 && orient(q0, p1, q1) > 0 && orient(p1, p0, q1) > 0);
+        if (right_step && left_step) {
+            StripQuad quad;
+            quad.spoke0 = squaredDistance(p0, q0);
+            quad.spoke1 = squaredDistance(p1, q1);
+            quad.outer = squaredDistance(p0, p1);
+            quad.inner = squaredDistance(q0, q1);
+            quad.diagonal0 = squaredDistance(p0, q1);
+            quad.diagonal1 = squaredDistance(p1, q0);
+            left_step = !Rule::advanceInner(quad);
+        } else if (!right_step && !left_step) {
+            // Only a gap without area gets here; move on along it without triangles
+            if (right_steps > 0) {
+                b = b1;
+                --right_steps;
+            } else {
+                a = a1;
+                --left_steps;
+            }
+            continue;
+        }
+
+        if (left_step) {
+            sink.triangle(p0.index, q0.index, p1.index);
+            sink.edge(p1.index, q0.index);
+            a = a1;
+            --left_steps;
+        } else {
+            sink.triangle(p0.index, q0.index, q1.index);
+            sink.edge(p0.index, q1.index);
+            b = b1;
+            --right_steps;
+        }
+    }
+
+    // The hull of both: the right one from the lower to the upper bridge, then the left one back
+    merged.clear();
+    size_t right_count = (upper_b + right_size - lower_b) % right_size + 1;
+    for (size_t i = lower_b, n = 0; n < right_count; i = right_next(i), ++n)
+        merged.push_back(right[i]);
+    size_t left_count = (lower_a + left_size - upper_a) % left_size + 1;
+    for (size_t i = upper_a, n = 0; n < left_count; i = left_next(i), ++n)
+        merged.push_back(left[i]);
+    left.swap(merged);
+}
+
+void stitchSeam(DiagonalRule rule, std::vector<HullVertex> &left, const std::vector<HullVertex> &right,
+                std::vector<HullVertex> &merged, MeshSink &sink)
+{
+    switch (rule) {
+    case DIAGONAL_MAX_MIN_ANGLE:
+        stitchSeam<MaxMinAngleRule>(left, right, merged, sink);
+        break;
+    case DIAGONAL_MIN_MAX_ANGLE:
+        stitchSeam<MinMaxAngleRule>(left, right, merged, sink);
+        break;
+    case DIAGONAL_SHORTEST:
+        stitchSeam<ShortestDiagonalRule>(left, right, merged, sink);
+        break;
+    }
+}
+
+// Append a file to the writer
+bool copyFile(const std::string &filename, BufferedWriter &out)
+{
+    FILE *in = fopen(filename.c_str(), "rb");
+    if (!in)
+        return false;
+    std::vector<char> block(size_t(1) << 20);
+    size_t size;
+    while ((size = fread(block.data(), 1, block.size(), in)) > 0)
+        out.write(block.data(), size);
+    bool ok = !ferror(in);
+    fclose(in);
+    return ok;
+}
+
+}
+
+bool triangulateTiled(const std::string &input, PointFormat format, const std::string &output,
+                      const TiledOptions &options, TiledStats &stats)
+{
+    stats = TiledStats();
+    PhaseTimer total_timer(stats.totalTime);
+
+    PointReader reader;
+    if (!reader.open(input, format))
+        return false;
+    BufferedWriter out(output);
+    if (!out.isOpen())
+        return false;
+
+    std::string prefix = options.scratchPrefix.empty() ? output : options.scratchPrefix;
+    ScratchFiles scratch;
+
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LTMS", 4);
+    header.version = MESH_FILE_VERSION;
+    header.vertexOffset = alignBlock(sizeof(header));
+    out.writeZeros(size_t(header.vertexOffset));
+
+    std::vector<real> xs(BLOCK_POINTS), ys(BLOCK_POINTS);
+    std::vector<uint64_t> histogram(HISTOGRAM_BINS, 0);
+    std::vector<uint64_t> slab_sizes;
+    std::vector<uint32_t> bin_slabs(HISTOGRAM_BINS, 0);
+    real min_x = std::numeric_limits<real>::max(), max_x = -std::numeric_limits<real>::max(), scale = 0;
+    auto bin = [&](real x) {
+        real position = (x - min_x) * scale;
+        return position > 0 ? std::min(size_t(position), HISTOGRAM_BINS - 1) : size_t(0);
+    };
+
+    {
+        PhaseTimer timer(stats.partitionTime);
+
+        // x of the vertex block and the range of x
+        uint64_t count = 0;
+        for (size_t size; (size = reader.read(xs.data(), ys.data(), BLOCK_POINTS)) > 0; count += size) {
+            for (size_t i = 0; i < size; ++i) {
+                min_x = std::min(min_x, xs[i]);
+                max_x = std::max(max_x, xs[i]);
+            }
+            out.write(xs.data(), size * sizeof(double));
+        }
+        if (reader.failed() || count > uint64_t(std::numeric_limits<int32_t>::max()))
+            return false;
+        stats.points = header.vertexCount = count;
+        if (max_x > min_x)
+            scale = real(HISTOGRAM_BINS) / (max_x - min_x);
+
+        // y of the vertex block and the histogram
+        if (!reader.rewind())
+            return false;
+        for (size_t size; (size = reader.read(xs.data(), ys.data(), BLOCK_POINTS)) > 0; ) {
+            for (size_t i = 0; i < size; ++i)
+                ++histogram[bin(xs[i])];
+            out.write(ys.data(), size * sizeof(double));
+        }
+        if (reader.failed())
+            return false;
+
+        // Slabs of whole bins up to the budget
+        uint64_t capacity = std::max<uint64_t>(options.memoryBudget / BYTES_PER_SLAB_POINT, 1024), current = 0;
+        for (size_t b = 0; b < HISTOGRAM_BINS; ++b) {
+            if (histogram[b] > 0 && current > 0 && current + histogram[b] > capacity) {
+                slab_sizes.push_back(current);
+                current = 0;
+            }
+            bin_slabs[b] = uint32_t(slab_sizes.size());
+            current += histogram[b];
+        }
+        if (current > 0)
+            slab_sizes.push_back(current);
+        stats.slabs = slab_sizes.size();
+
+        // Points into their slab files, a group of files per pass
+        size_t slab_count = slab_sizes.size();
+        size_t buffer_size = options.memoryBudget / 4 / std::max<size_t>(1, std::min(slab_count, MAX_OPEN_SLABS));
+        buffer_size = std::max<size_t>(4096, std::min<size_t>(buffer_size, size_t(1) << 20));
+        for (size_t group = 0; group < slab_count; group += MAX_OPEN_SLABS) {
+            size_t group_end = std::min(slab_count, group + MAX_OPEN_SLABS);
+            std::vector<std::unique_ptr<BufferedWriter> > slabs;
+            for (size_t s = group; s < group_end; ++s) {
+                scratch.names.push_back(prefix + ".slab" + std::to_string(s));
+                slabs.emplace_back(new BufferedWriter(scratch.names.back(), buffer_size));
+                if (!slabs.back()->isOpen())
+                    return false;
+            }
+
+            if (!reader.rewind())
+                return false;
+            uint64_t index = 0;
+            for (size_t size; (size = reader.read(xs.data(), ys.data(), BLOCK_POINTS)) > 0; ) {
+                for (size_t i = 0; i < size; ++i, ++index) {
+                    size_t s = bin_slabs[bin(xs[i])];
+                    if (s >= group && s < group_end) {
+                        SlabPoint point = { xs[i], ys[i], index };
+                        slabs[s - group]->write(&point, sizeof(point));
+                    }
+                }
+            }
+            if (reader.failed())
+                return false;
+            for (std::unique_ptr<BufferedWriter> &slab : slabs) {
+                if (!slab->close())
+                    return false;
+            }
+        }
+        reader.close();
+    }
+    std::vector<uint64_t>().swap(histogram);
+    std::vector<uint32_t>().swap(bin_slabs);
+
+    out.writeZeros(size_t(alignBlock(out.position()) - out.position()));
+    header.triangleOffset = out.position();
+    scratch.names.push_back(prefix + ".edges");
+    BufferedWriter edges(scratch.names.back());
+    if (!edges.isOpen())
+        return false;
+    MeshSink sink(out, edges);
+
+    TriangulationOptions slab_options = options.triangulation;
+    slab_options.layerEngine = LAYERS_HULL_TREE;
+    slab_options.topology = MESH_TRIANGLES;
+    slab_options.delaunayFlips = false;
+    BasicLayerTriangulation<real, int> triangulation(slab_options);
+
+    std::vector<real> slab_x, slab_y;
+    std::vector<int32_t> slab_index;
+    std::vector<SlabPoint> records(BLOCK_POINTS);
+    std::vector<HullVertex> hull, slab_hull, merged;
+
+    for (size_t s = 0; s < slab_sizes.size(); ++s) {
+        {
+            PhaseTimer timer(stats.triangulationTime);
+
+            const std::string &name = scratch.names[s];
+            FILE *in = fopen(name.c_str(), "rb");
+            if (!in)
+                return false;
+            slab_x.clear();
+            slab_y.clear();
+            slab_index.clear();
+            size_t size;
+            while ((size = fread(records.data(), sizeof(SlabPoint), records.size(), in)) > 0) {
+                for (size_t i = 0; i < size; ++i) {
+                    slab_x.push_back(records[i].x);
+                    slab_y.push_back(records[i].y);
+                    slab_index.push_back(int32_t(records[i].index));
+                }
+            }
+            bool read_error = ferror(in) != 0;
+            fclose(in);
+            std::remove(name.c_str());
+            if (read_error || slab_x.size() != slab_sizes[s])
+                return false;
+            stats.largestSlab = std::max(stats.largestSlab, slab_x.size());
+
+            triangulation.triangulate(slab_x.data(), slab_y.data(), slab_x.size());
+
+            const std::vector<int> &triangles = triangulation.mesh.triangles;
+            for (size_t t = 0; t < triangles.size(); t += 3)
+                sink.triangle(slab_index[triangles[t]], slab_index[triangles[t + 1]], slab_index[triangles[t + 2]]);
+            const std::vector<std::pair<int,int> > &edges = triangulation.edges;
+            for (const std::pair<int,int> &edge : edges)
+                sink.edge(slab_index[edge.first], slab_index[edge.second]);
+
+            // Without flips only a collinear slab has its sides among the edges: they are the path
+            // along its points, and its hull runs out along the path and back so that the seams
+            // reach every point of it
+            auto vertex = [&](int point) { return HullVertex{ slab_x[point], slab_y[point], slab_index[point] }; };
+            const LayerList<int> &layers = triangulation.layers;
+            slab_hull.clear();
+            if (triangulation.edgesIncludeSides()) {
+                slab_hull.push_back(vertex(edges.front().first));
+                for (const std::pair<int,int> &edge : edges)
+                    slab_hull.push_back(vertex(edge.second));
+                for (size_t i = edges.size() - 1; i > 0; --i)
+                    slab_hull.push_back(vertex(edges[i].first));
+            } else {
+                forEachLayerSide(layers, [&](int i1, int i2) { sink.edge(slab_index[i1], slab_index[i2]); });
+                if (!layers.empty()) {
+                    for (int point : layers[0])
+                        slab_hull.push_back(vertex(point));
+                }
+            }
+        }
+
+        PhaseTimer timer(stats.seamTime);
+        if (s == 0)
+            hull.swap(slab_hull);
+        else
+            stitchSeam(slab_options.diagonalRule, hull, slab_hull, merged, sink);
+    }
+
+    // Edges after the triangles, then the final header
+    if (!edges.close())
+        return false;
+    header.triangleCount = sink.triangleCount;
+    header.neighborOffset = header.edgeOffset = alignBlock(out.position());
+    header.edgeCount = sink.edgeCount;
+    out.writeZeros(size_t(header.edgeOffset - out.position()));
+    if (!copyFile(scratch.names.back(), out) || !out.close())
+        return false;
+
+    FILE *file = fopen(output.c_str(), "r+b");
+    if (!file)
+        return false;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (fclose(file) != 0 || !written)
+        return false;
+
+    stats.triangles = sink.triangleCount;
+    stats.edges = sink.edgeCount;
+    stats.peakMemory = peakMemoryUsage();
+    return true;
+}
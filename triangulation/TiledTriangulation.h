@@ -0,0 +1,56 @@
+#ifndef TILEDTRIANGULATION_H
+#define TILEDTRIANGULATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "LayerTriangulation.h"
+#include "PointIO.h"
+
+// Out-of-core triangulation of point files larger than memory. The input is streamed three times:
+// to copy x into the output, to copy y and take a histogram of x, and to distribute the points over
+// vertical slabs cut from the histogram, each into a scratch file. The slabs are then triangulated
+// one at a time from left to right. The gap between the hull of the slabs done so far and the hull
+// of the next one is closed by walking their facing chains from the lower to the upper bridge.
+// Triangles and edges are written as they come, so memory holds one slab and the hull of the
+// slabs left of it.
+struct TiledOptions
+{
+    TiledOptions();
+
+    // Options of the slab triangulations. The seams need the points on hull sides, which the
+    // outer layer keeps, and the path through a collinear slab. The hull tree engine is always
+    // used, the topology is always triangles and Delaunay flips are not done.
+    TriangulationOptions triangulation;
+
+    // Bytes for the points and the triangulation of a slab
+    size_t memoryBudget;
+
+    // Scratch files are named scratchPrefix followed by a suffix, the output name by default
+    std::string scratchPrefix;
+};
+
+struct TiledStats
+{
+    TiledStats();
+
+    uint64_t points, triangles, edges;
+    size_t slabs, largestSlab;
+
+    // Wall time in seconds: the passes over the input, the slab triangulations including writing
+    // them out, and the seams
+    double partitionTime, triangulationTime, seamTime, totalTime;
+
+    // Peak resident memory of the process in bytes
+    size_t peakMemory;
+};
+
+// Triangulate the points of input into a mesh file of the compact binary format (MeshFileHeader)
+// with vertices, triangles and edges, without neighbors. Points sharing a histogram bin stay in
+// one slab, which may exceed the budget then. Returns false if a file cannot be read or written
+// or the input has more than 2^31 - 1 points.
+bool triangulateTiled(const std::string &input, PointFormat format, const std::string &output,
+                      const TiledOptions &options, TiledStats &stats);
+
+#endif // TILEDTRIANGULATION_H
@@ -0,0 +1,48 @@
+#ifndef TRIANGLEMESH_H
+#define TRIANGLEMESH_H
+
+#include <vector>
+
+enum MeshTopology
+{
+    MESH_EDGES_ONLY,    // Only the flat edges vector
+    MESH_TRIANGLES,     // Triangles and their neighbors
+    MESH_HALF_EDGES     // Triangles, neighbors and the half-edge structure
+};
+
+// Indexed triangle mesh. Triangle t owns the half-edges 3t, 3t + 1 and 3t + 2, half-edge
+// 3t + k starts at vertex triangles[3t + k] and ends at the start of the next one.
+template <typename Index>
+struct BasicTriangleMesh
+{
+    // Marks a missing triangle or half-edge, -1 converted to the index type
+    static constexpr Index NONE = Index(-1);
+
+    // Vertex triples, counterclockwise
+    std::vector<Index> triangles;
+
+    // Triangle on the other side of every half-edge, NONE on the convex hull
+    std::vector<Index> neighbors;
+
+    // Opposite half-edge of every half-edge, NONE on the convex hull (MESH_HALF_EDGES)
+    std::vector<Index> halfedges;
+
+    // One half-edge leaving every vertex, the hull edge for hull vertices (MESH_HALF_EDGES)
+    std::vector<Index> vertexEdges;
+
+    size_t size() const { return triangles.size() / 3; }
+
+    void clear() {
+        triangles.clear();
+        neighbors.clear();
+        halfedges.clear();
+        vertexEdges.clear();
+    }
+
+    static Index next(Index edge) { return edge % 3 == 2 ? edge - 2 : edge + 1; }
+    static Index prev(Index edge) { return edge % 3 == 0 ? edge + 2 : edge - 1; }
+};
+
+typedef BasicTriangleMesh<int> TriangleMesh;
+
+#endif // TRIANGLEMESH_H
@@ -0,0 +1,57 @@
+#ifndef TRIANGULATIONWORKSPACE_H
+#define TRIANGULATIONWORKSPACE_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "AngularSort.h"
+#include "ConvexLayers.h"
+#include "Duplicates.h"
+#include "EdgeFlips.h"
+#include "MeshOrder.h"
+
+// Scratch memory of the triangulation pipeline. The buffers only ever grow, so once a workspace
+// has served the largest input of a series the rest run without heap allocations. A workspace
+// can be shared by triangulations running one after another, but not concurrently.
+template <typename Index>
+struct TriangulationWorkspace
+{
+    // Duplicate removal
+    DuplicateBuffers<Index> duplicates;
+
+    // Hull tree engine
+    PeelBuffers<Index> peel;
+
+    // Graham scan engine: the angular sort, the points left and those inside the current layer,
+    // which swap roles after every scan, the scan state and the points the octagon filter passed
+    AngularSortBuffers<Index> sort;
+    std::vector<Index> indices, inner;
+    std::vector<bool> mask;
+    std::vector<size_t> hull;
+    std::vector<uint8_t> interior;
+
+    // First spoke and triangle of every strip between two layers
+    std::vector<size_t> stripOffsets;
+
+    // Mesh construction: the pairing of the half-edges
+    std::vector<Index> twins, inside, outside;
+
+    // Delaunay flips
+    FlipBuffers<Index> flips;
+
+    // Dynamic updates: the changed points, the points peeled again and their layers, the layers,
+    // strip offsets and edges before the update, and the balance and border marks of every point
+    std::vector<Index> inserted, erased, window;
+    LayerList<Index> repaired, previousLayers;
+    std::vector<size_t> previousOffsets;
+    std::vector<std::pair<Index,Index> > previousEdges;
+    std::vector<int8_t> balance;
+    std::vector<uint8_t> border;
+
+    // Reordering of the output, also sorting the queries of point location
+    MeshOrderBuffers<Index> order;
+    std::vector<Index> queryOrder;
+};
+
+#endif // TRIANGULATIONWORKSPACE_H
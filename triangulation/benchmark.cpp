@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "BatchTriangulation.h"
+#include "Generators.h"
+#include "LayerTriangulation.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+
+struct BenchmarkResult
+{
+    Distribution distribution;
+    size_t points;
+    std::vector<double> times;
+    size_t layers, triangles, edges;
+
+    // Stats of the last run
+    TriangulationStats stats;
+
+    double best() const { return *std::min_element(times.begin(), times.end()); }
+    double mean() const {
+        double sum = 0.0;
+        for (double time : times)
+            sum += time;
+        return sum / times.size();
+    }
+    double median() const {
+        std::vector<double> sorted(times);
+        std::sort(sorted.begin(), sorted.end());
+        size_t middle = sorted.size() / 2;
+        return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+    }
+};
+
+// Instantiations of the triangulation that can be timed
+enum CoordinateType { COORDINATES_DOUBLE, COORDINATES_FLOAT, COORDINATES_INT32, COORDINATES_INT64 };
+enum IndexType { INDICES_INT, INDICES_UINT32, INDICES_UINT64 };
+
+const char *const COORDINATE_NAMES[] = { "double", "float", "int32", "int64" };
+const char *const INDEX_NAMES[] = { "int", "uint32", "uint64" };
+
+// Indexed by LayerEngine, MeshTopology and DiagonalRule
+const char *const ENGINE_NAMES[] = { "graham", "hull-tree" };
+const char *const TOPOLOGY_NAMES[] = { "edges", "triangles", "half-edges" };
+const char *const DIAGONAL_NAMES[] = { "min-angle", "max-angle", "shortest" };
+
+void usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+                 "  --distributions LIST   comma separated, default all of:\n"
+                 "                         uniform-square,uniform-disk,gaussian,clustered,circle,integer-grid\n"
+                 "  --sizes LIST           comma separated point counts, k and M suffixes allowed (default 1k,10k,100k,1M)\n"
+                 "  --repetitions N        timed runs per input (default 5)\n"
+                 "  --warmup N             untimed runs per input (default 1)\n"
+                 "  --threads N            worker threads, 0 - all hardware threads (default)\n"
+                 "  --engine graham|hull-tree (default graham)\n"
+                 "  --topology edges|triangles|half-edges\n"
+                 "  --diagonal min-angle|max-angle|shortest\n"
+                 "  --delaunay yes|no      flip the edges to the Delaunay triangulation (default no)\n"
+                 "  --coordinates double|float|int32|int64\n"
+                 "                         coordinate type, integers as fixed point (default double)\n"
+                 "  --indices int|uint32|uint64\n"
+                 "                         index type (default int)\n"
+                 "  --tiles N              split every input into sets of N points and triangulate\n"
+                 "                         them as one batch (default 0, a single triangulation)\n"
+                 "  --seed N               generator seed (default 1)\n"
+                 "  --format json|csv      result format (default json)\n"
+                 "  --output FILE          write results to FILE instead of stdout\n";
+}
+
+std::vector<std::string> split(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+bool parseSize(const std::string &text, size_t &size)
+{
+    char *end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    if (end == text.c_str())
+        return false;
+    if (*end == 'k' || *end == 'K') {
+        value *= 1e3; ++end;
+    } else if (*end == 'm' || *end == 'M') {
+        value *= 1e6; ++end;
+    }
+    if (*end != '\0' || value < 1)
+        return false;
+    size = size_t(value);
+    return true;
+}
+
+bool parseName(const std::string &text, const char *const *names, int count, int &value)
+{
+    for (int i = 0; i < count; ++i) {
+        if (text == names[i]) {
+            value = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Integer coordinates are fixed point with the largest magnitude at 2^30 (int32) or 2^52 (int64)
+template <typename Coord>
+void convertCoordinates(const RealArray &from, size_t size, real scale, CoordArray<Coord> &to)
+{
+    to.resize(size);
+    for (size_t i = 0; i < size; ++i)
+        to[i] = std::is_integral<Coord>::value ? Coord(std::llround(from[i] * scale)) : Coord(from[i]);
+}
+
+template <typename Coord, typename Index>
+void timeRuns(const RealArray &x, const RealArray &y, size_t size, size_t tile_size,
+              const TriangulationOptions &options, int warmup, int repetitions, BenchmarkResult &result)
+{
+    real scale = 1.0;
+    if (std::is_integral<Coord>::value) {
+        real largest = 0.0;
+        for (size_t i = 0; i < size; ++i)
+            largest = std::max(largest, std::max(std::fabs(x[i]), std::fabs(y[i])));
+        if (largest > 0.0)
+            scale = std::ldexp(1.0, sizeof(Coord) == 4 ? 30 : 52) / largest;
+    }
+    CoordArray<Coord> cx, cy;
+    convertCoordinates(x, size, scale, cx);
+    convertCoordinates(y, size, scale, cy);
+
+    if (tile_size > 0) {
+        std::vector<size_t> offsets;
+        for (size_t first = 0; first < size; first += tile_size)
+            offsets.push_back(first);
+        offsets.push_back(size);
+
+        BasicBatchResult<Index> batch;
+        for (int run = 0; run < warmup + repetitions; ++run) {
+            Timer timer;
+            triangulateBatch(cx.data(), cy.data(), offsets.data(), offsets.size() - 1, options, batch);
+            double time = timer.elapsed();
+
+            if (run >= warmup)
+                result.times.push_back(time);
+            result.layers = 0;
+            for (size_t layers : batch.layerCounts)
+                result.layers += layers;
+            result.triangles = batch.mesh.size();
+            result.edges = batch.edges.size();
+        }
+        return;
+    }
+
+    for (int run = 0; run < warmup + repetitions; ++run) {
+        Timer timer;
+        BasicLayerTriangulation<Coord, Index> triangulation(cx.data(), cy.data(), size, options);
+        double time = timer.elapsed();
+
+        if (run >= warmup)
+            result.times.push_back(time);
+        result.layers = triangulation.layers.size();
+        result.triangles = triangulation.mesh.size();
+        result.edges = triangulation.edges.size();
+        result.stats = triangulation.stats;
+    }
+}
+
+template <typename Coord>
+void timeRuns(IndexType indices, const RealArray &x, const RealArray &y, size_t size, size_t tile_size,
+              const TriangulationOptions &options, int warmup, int repetitions, BenchmarkResult &result)
+{
+    switch (indices) {
+    case INDICES_INT:
+        timeRuns<Coord, int>(x, y, size, tile_size, options, warmup, repetitions, result);
+        break;
+    case INDICES_UINT32:
+        timeRuns<Coord, uint32_t>(x, y, size, tile_size, options, warmup, repetitions, result);
+        break;
+    case INDICES_UINT64:
+        timeRuns<Coord, uint64_t>(x, y, size, tile_size, options, warmup, repetitions, result);
+        break;
+    }
+}
+
+void writeJSON(FILE *out, const std::vector<BenchmarkResult> &results, const TriangulationOptions &options,
+               unsigned threads, CoordinateType coordinates, IndexType indices, size_t tile_size)
+{
+    fprintf(out, "{\n  \"engine\": \"%s\",\n  \"threads\": %u,\n  \"coordinates\": \"%s\",\n  "
+                 "\"indices\": \"%s\",\n  \"diagonal\": \"%s\",\n  \"delaunay\": %s,\n  \"tiles\": %zu,\n  \"results\": [",
+            ENGINE_NAMES[options.layerEngine], threads,
+            COORDINATE_NAMES[coordinates], INDEX_NAMES[indices], DIAGONAL_NAMES[options.diagonalRule],
+            options.delaunayFlips ? "true" : "false", tile_size);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult &result = results[i];
+        fprintf(out, "%s\n    {\"distribution\": \"%s\", \"points\": %zu, \"layers\": %zu, \"triangles\": %zu, "
+                     "\"edges\": %zu, \"repetitions\": %zu, \"best_s\": %.9f, \"median_s\": %.9f, \"mean_s\": %.9f, "
+                     "\"points_per_s\": %.1f, \"times_s\": [",
+                i ? "," : "", distributionName(result.distribution), result.points, result.layers, result.triangles,
+                result.edges, result.times.size(), result.best(), result.median(), result.mean(),
+                result.points / result.median());
+        for (size_t run = 0; run < result.times.size(); ++run)
+            fprintf(out, "%s%.9f", run ? ", " : "", result.times[run]);
+        fprintf(out, "], \"stats\": %s}", result.stats.toJSON().c_str());
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+void writeCSV(FILE *out, const std::vector<BenchmarkResult> &results)
+{
+    fprintf(out, "distribution,points,layers,triangles,edges,repetitions,best_s,median_s,mean_s,points_per_s\n");
+    for (const BenchmarkResult &result : results) {
+        fprintf(out, "%s,%zu,%zu,%zu,%zu,%zu,%.9f,%.9f,%.9f,%.1f\n",
+                distributionName(result.distribution), result.points, result.layers, result.triangles,
+                result.edges, result.times.size(), result.best(), result.median(), result.mean(),
+                result.points / result.median());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<Distribution> distributions;
+    std::vector<size_t> sizes;
+    int repetitions = 5, warmup = 1;
+    size_t tile_size = 0;
+    uint64_t seed = 1;
+    bool csv = false;
+    std::string output;
+    TriangulationOptions options;
+    CoordinateType coordinates = COORDINATES_DOUBLE;
+    IndexType indices = INDICES_INT;
+
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string name = argv[arg];
+        if (arg + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++arg];
+
+        bool valid = true;
+        if (name == "--distributions") {
+            for (const std::string &item : split(value)) {
+                Distribution distribution;
+                valid = valid && parseDistribution(item, distribution);
+                distributions.push_back(distribution);
+            }
+        } else if (name == "--sizes") {
+            for (const std::string &item : split(value)) {
+                size_t size = 0;
+                valid = valid && parseSize(item, size);
+                sizes.push_back(size);
+            }
+        } else if (name == "--repetitions") {
+            repetitions = atoi(value.c_str());
+            valid = repetitions > 0;
+        } else if (name == "--warmup") {
+            warmup = atoi(value.c_str());
+        } else if (name == "--threads") {
+            options.threads = (unsigned)atoi(value.c_str());
+        } else if (name == "--engine") {
+            int engine = 0;
+            valid = parseName(value, ENGINE_NAMES, 2, engine);
+            options.layerEngine = LayerEngine(engine);
+        } else if (name == "--topology") {
+            int topology = 0;
+            valid = parseName(value, TOPOLOGY_NAMES, 3, topology);
+            options.topology = MeshTopology(topology);
+        } else if (name == "--diagonal") {
+            int rule = 0;
+            valid = parseName(value, DIAGONAL_NAMES, 3, rule);
+            options.diagonalRule = DiagonalRule(rule);
+        } else if (name == "--delaunay") {
+            options.delaunayFlips = value == "yes";
+            valid = options.delaunayFlips || value == "no";
+        } else if (name == "--coordinates") {
+            int type = 0;
+            valid = parseName(value, COORDINATE_NAMES, 4, type);
+            coordinates = CoordinateType(type);
+        } else if (name == "--indices") {
+            int type = 0;
+            valid = parseName(value, INDEX_NAMES, 3, type);
+            indices = IndexType(type);
+        } else if (name == "--tiles") {
+            tile_size = strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--seed") {
+            seed = strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--format") {
+            csv = value == "csv";
+            valid = csv || value == "json";
+        } else if (name == "--output") {
+            output = value;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (distributions.empty())
+        for (int i = 0; i < DISTRIBUTION_COUNT; ++i)
+            distributions.push_back(Distribution(i));
+    if (sizes.empty())
+        sizes = { 1000, 10000, 100000, 1000000 };
+
+    // Generation and every run share one pool, so thread start-up is not timed
+    ThreadPool pool(options.threads);
+    options.pool = &pool;
+
+    std::vector<BenchmarkResult> results;
+    RealArray x, y;
+    for (Distribution distribution : distributions) {
+        for (size_t size : sizes) {
+            generatePoints(distribution, size, seed, x, y, &pool);
+
+            BenchmarkResult result;
+            result.distribution = distribution;
+            result.points = size;
+
+            switch (coordinates) {
+            case COORDINATES_DOUBLE:
+                timeRuns<double>(indices, x, y, size, tile_size, options, warmup, repetitions, result);
+                break;
+            case COORDINATES_FLOAT:
+                timeRuns<float>(indices, x, y, size, tile_size, options, warmup, repetitions, result);
+                break;
+            case COORDINATES_INT32:
+                timeRuns<int32_t>(indices, x, y, size, tile_size, options, warmup, repetitions, result);
+                break;
+            case COORDINATES_INT64:
+                timeRuns<int64_t>(indices, x, y, size, tile_size, options, warmup, repetitions, result);
+                break;
+            }
+            results.push_back(result);
+
+            fprintf(stderr, "%-15s %10zu points  %8.3f ms  %12.0f points/s  %zu layers\n",
+                    distributionName(distribution), size, result.median() * 1000, size / result.median(),
+                    result.layers);
+        }
+    }
+
+    FILE *out = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if (!out) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+    if (csv)
+        writeCSV(out, results);
+    else
+        writeJSON(out, results, options, pool.size(), coordinates, indices, tile_size);
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
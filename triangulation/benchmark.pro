@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = benchmark
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+
+include(triangulation.pri)
+
+SOURCES += \
+    benchmark.cpp
@@ -0,0 +1,312 @@
+#include "capi.h"
+#include "LayerTriangulation.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace {
+
+// Half-edges are numbered up to six times the points, all below LT_NONE
+const size_t MAX_POINTS = (size_t(UINT32_MAX) - 1) / 6;
+
+// Triangulation over one coordinate type and the packed copies of strided coordinates
+template <typename Coord>
+struct Part
+{
+    std::unique_ptr<BasicLayerTriangulation<Coord, uint32_t> > triangulation;
+    CoordArray<Coord> x, y;
+};
+
+}
+
+struct lt_triangulation
+{
+    Part<double> f64;
+    Part<float> f32;
+
+    // Packed copies of strided queries
+    std::vector<real> queryX, queryY;
+};
+
+namespace {
+
+Part<double> &part(lt_triangulation &handle, double) { return handle.f64; }
+Part<float> &part(lt_triangulation &handle, float) { return handle.f32; }
+
+// Call function with the triangulation of the handle, whichever coordinate type it has
+template <typename Function>
+auto visit(const lt_triangulation *handle, Function function) -> decltype(function(*handle->f64.triangulation))
+{
+    return handle->f64.triangulation ? function(*handle->f64.triangulation) : function(*handle->f32.triangulation);
+}
+
+// Fields the caller knows of over the defaults, false for values out of range
+bool convertOptions(const lt_options *given, TriangulationOptions &out)
+{
+    lt_options options;
+    lt_options_init(&options);
+    if (given) {
+        if (given->size < sizeof(uint32_t))
+            return false;
+        memcpy(&options, given, std::min<size_t>(given->size, sizeof(options)));
+    }
+    if (options.engine < LT_ENGINE_GRAHAM_SCAN || options.engine > LT_ENGINE_HULL_TREE ||
+        options.topology < LT_TOPOLOGY_EDGES || options.topology > LT_TOPOLOGY_HALF_EDGES ||
+        options.diagonal < LT_DIAGONAL_MAX_MIN_ANGLE || options.diagonal > LT_DIAGONAL_SHORTEST ||
+        !(options.duplicate_tolerance >= 0))
+        return false;
+
+    out.threads = options.threads;
+    out.layerEngine = LayerEngine(options.engine);
+    out.topology = MeshTopology(options.topology);
+    out.diagonalRule = DiagonalRule(options.diagonal);
+    out.delaunayFlips = options.delaunay != 0;
+    out.removeDuplicates = options.remove_duplicates != 0;
+    out.duplicateTolerance = options.duplicate_tolerance;
+    return true;
+}
+
+// Point x and y at packed arrays: the caller's own ones for stride 0 or the value size,
+// otherwise copies gathered into xs and ys. False for a stride shorter than a value.
+template <typename Coord, typename Array>
+bool packCoordinates(const Coord *&x, const Coord *&y, size_t count, size_t stride, Array &xs, Array &ys)
+{
+    if (stride == 0 || stride == sizeof(Coord))
+        return true;
+    if (stride < sizeof(Coord))
+        return false;
+
+    // Strided values need not be aligned, so they are copied bytewise
+    const char *x_bytes = reinterpret_cast<const char*>(x), *y_bytes = reinterpret_cast<const char*>(y);
+    xs.resize(count);
+    ys.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(&xs[i], x_bytes + i * stride, sizeof(Coord));
+        memcpy(&ys[i], y_bytes + i * stride, sizeof(Coord));
+    }
+    x = xs.data();
+    y = ys.data();
+    return true;
+}
+
+template <typename Coord>
+int triangulate(const Coord *x, const Coord *y, size_t count, size_t stride, const lt_options *options,
+                lt_triangulation **out)
+{
+    if (!out)
+        return LT_INVALID_ARGUMENT;
+    *out = nullptr;
+    TriangulationOptions converted;
+    if ((count > 0 && (!x || !y)) || !convertOptions(options, converted))
+        return LT_INVALID_ARGUMENT;
+    if (count > MAX_POINTS)
+        return LT_TOO_LARGE;
+
+    try {
+        std::unique_ptr<lt_triangulation> handle(new lt_triangulation);
+        Part<Coord> &own = part(*handle, Coord());
+        if (!packCoordinates(x, y, count, stride, own.x, own.y))
+            return LT_INVALID_ARGUMENT;
+        own.triangulation.reset(new BasicLayerTriangulation<Coord, uint32_t>(x, y, count, converted));
+        own.triangulation->releaseWorkspace();
+        *out = handle.release();
+        return LT_OK;
+    } catch (const std::bad_alloc &) {
+        return LT_OUT_OF_MEMORY;
+    } catch (...) {
+        return LT_SYSTEM_ERROR;
+    }
+}
+
+template <typename Triangulation>
+size_t edgeCount(const Triangulation &triangulation)
+{
+    size_t count = triangulation.edges.size();
+    return triangulation.edgesIncludeSides() ? count : count + layerSideCount(triangulation.layers);
+}
+
+// Edges between the layers, then the layer sides unless the edges hold them already
+template <typename Triangulation>
+void copyEdges(const Triangulation &triangulation, uint32_t *pairs)
+{
+    for (const std::pair<uint32_t,uint32_t> &edge : triangulation.edges) {
+        *pairs++ = edge.first;
+        *pairs++ = edge.second;
+    }
+    if (!triangulation.edgesIncludeSides()) {
+        forEachLayerSide(triangulation.layers, [&pairs](uint32_t i1, uint32_t i2) {
+            *pairs++ = i1;
+            *pairs++ = i2;
+        });
+    }
+}
+
+}
+
+uint32_t lt_abi_version(void)
+{
+    return LT_ABI_VERSION;
+}
+
+const char *lt_status_string(int status)
+{
+    switch (status) {
+    case LT_OK: return "success";
+    case LT_INVALID_ARGUMENT: return "invalid argument";
+    case LT_TOO_LARGE: return "too many points";
+    case LT_BUFFER_TOO_SMALL: return "buffer too small";
+    case LT_OUT_OF_MEMORY: return "out of memory";
+    case LT_IO_ERROR: return "cannot write file";
+    case LT_SYSTEM_ERROR: return "system error";
+    default: return "unknown status";
+    }
+}
+
+void lt_options_init(lt_options *options)
+{
+    if (!options)
+        return;
+    TriangulationOptions defaults;
+    memset(options, 0, sizeof(*options));
+    options->size = sizeof(*options);
+    options->threads = defaults.threads;
+    options->engine = defaults.layerEngine;
+    options->topology = defaults.topology;
+    options->diagonal = defaults.diagonalRule;
+    options->delaunay = defaults.delaunayFlips;
+    options->remove_duplicates = defaults.removeDuplicates;
+    options->duplicate_tolerance = defaults.duplicateTolerance;
+}
+
+int lt_triangulate(const double *x, const double *y, size_t count, size_t stride, const lt_options *options,
+                   lt_triangulation **out)
+{
+    return triangulate(x, y, count, stride, options, out);
+}
+
+int lt_triangulate_f32(const float *x, const float *y, size_t count, size_t stride, const lt_options *options,
+                       lt_triangulation **out)
+{
+    return triangulate(x, y, count, stride, options, out);
+}
+
+void lt_destroy(lt_triangulation *triangulation)
+{
+    delete triangulation;
+}
+
+size_t lt_point_count(const lt_triangulation *triangulation)
+{
+    return triangulation ? visit(triangulation, [](const auto &t) { return t.points().size(); }) : 0;
+}
+
+size_t lt_layer_count(const lt_triangulation *triangulation)
+{
+    return triangulation ? visit(triangulation, [](const auto &t) { return t.layers.size(); }) : 0;
+}
+
+size_t lt_triangle_count(const lt_triangulation *triangulation)
+{
+    return triangulation ? visit(triangulation, [](const auto &t) { return t.mesh.size(); }) : 0;
+}
+
+size_t lt_edge_count(const lt_triangulation *triangulation)
+{
+    return triangulation ? visit(triangulation, [](const auto &t) { return edgeCount(t); }) : 0;
+}
+
+const uint32_t *lt_triangles(const lt_triangulation *triangulation)
+{
+    if (!triangulation)
+        return nullptr;
+    return visit(triangulation, [](const auto &t) { return t.mesh.triangles.empty() ? nullptr : t.mesh.triangles.data(); });
+}
+
+const uint32_t *lt_neighbors(const lt_triangulation *triangulation)
+{
+    if (!triangulation)
+        return nullptr;
+    return visit(triangulation, [](const auto &t) { return t.mesh.neighbors.empty() ? nullptr : t.mesh.neighbors.data(); });
+}
+
+const uint32_t *lt_layer_points(const lt_triangulation *triangulation)
+{
+    if (!triangulation)
+        return nullptr;
+    return visit(triangulation, [](const auto &t) { return t.layers.indices().data(); });
+}
+
+const size_t *lt_layer_offsets(const lt_triangulation *triangulation)
+{
+    if (!triangulation)
+        return nullptr;
+    return visit(triangulation, [](const auto &t) { return t.layers.offsets().data(); });
+}
+
+int lt_copy_edges(const lt_triangulation *triangulation, uint32_t *pairs, size_t capacity)
+{
+    if (!triangulation || (!pairs && capacity > 0))
+        return LT_INVALID_ARGUMENT;
+    if (lt_edge_count(triangulation) > capacity)
+        return LT_BUFFER_TOO_SMALL;
+    visit(triangulation, [pairs](const auto &t) { copyEdges(t, pairs); });
+    return LT_OK;
+}
+
+int lt_export_edges(const lt_triangulation *triangulation, uint32_t **pairs, size_t *count)
+{
+    if (!triangulation || !pairs || !count)
+        return LT_INVALID_ARGUMENT;
+    *pairs = nullptr;
+    *count = lt_edge_count(triangulation);
+
+    // malloc, so a buffer outlives the triangulation and can be released from any language
+    uint32_t *buffer = static_cast<uint32_t*>(malloc(2 * sizeof(uint32_t) * std::max<size_t>(*count, 1)));
+    if (!buffer)
+        return LT_OUT_OF_MEMORY;
+    visit(triangulation, [buffer](const auto &t) { copyEdges(t, buffer); });
+    *pairs = buffer;
+    return LT_OK;
+}
+
+void lt_free_buffer(void *buffer)
+{
+    free(buffer);
+}
+
+int lt_locate(lt_triangulation *triangulation, const double *x, const double *y, size_t count, size_t stride,
+              uint32_t *triangles)
+{
+    if (!triangulation || (count > 0 && (!x || !y || !triangles)))
+        return LT_INVALID_ARGUMENT;
+    try {
+        if (!packCoordinates(x, y, count, stride, triangulation->queryX, triangulation->queryY))
+            return LT_INVALID_ARGUMENT;
+        if (triangulation->f64.triangulation)
+            triangulation->f64.triangulation->locate(x, y, count, triangles);
+        else
+            triangulation->f32.triangulation->locate(x, y, count, triangles);
+        return LT_OK;
+    } catch (const std::bad_alloc &) {
+        return LT_OUT_OF_MEMORY;
+    } catch (...) {
+        return LT_SYSTEM_ERROR;
+    }
+}
+
+int lt_save(const lt_triangulation *triangulation, const char *filename, int format)
+{
+    if (!triangulation || !filename || format < LT_FORMAT_BINARY || format > LT_FORMAT_EDGES)
+        return LT_INVALID_ARGUMENT;
+    try {
+        bool saved = visit(triangulation, [&](const auto &t) { return t.saveMesh(filename, MeshFormat(format)); });
+        return saved ? LT_OK : LT_IO_ERROR;
+    } catch (const std::bad_alloc &) {
+        return LT_OUT_OF_MEMORY;
+    } catch (...) {
+        return LT_SYSTEM_ERROR;
+    }
+}
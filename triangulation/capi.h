@@ -0,0 +1,122 @@
+#ifndef CAPI_H
+#define CAPI_H
+
+// C interface of the layer triangulation, for the shared and static library targets
+// (library.pro, library_static.pro) and for bindings from other languages. Only plain C types
+// cross it: the triangulation is an opaque handle, options are a struct that only ever grows at
+// its end, and every function reports errors by its status instead of throwing.
+//
+// Points and triangles are numbered with uint32_t, LT_NONE marks a missing triangle.
+// Static builds need the C++ standard library and the threads library of the platform.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(LT_BUILD_SHARED)
+#define LT_API __declspec(dllexport)
+#elif defined(_WIN32) && defined(LT_SHARED)
+#define LT_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define LT_API __attribute__((visibility("default")))
+#else
+#define LT_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Raised only for incompatible changes of the functions below
+#define LT_ABI_VERSION 1
+
+#define LT_NONE 0xffffffffu
+
+enum
+{
+    LT_OK = 0,
+    LT_INVALID_ARGUMENT,    // Null pointer, unknown option value or stride too small
+    LT_TOO_LARGE,           // More points than the 32-bit numbering can hold
+    LT_BUFFER_TOO_SMALL,    // Caller buffer shorter than the result
+    LT_OUT_OF_MEMORY,
+    LT_IO_ERROR,            // File not written, or too many points for the format
+    LT_SYSTEM_ERROR         // Other failures of the runtime, such as threads not starting
+};
+
+enum { LT_ENGINE_GRAHAM_SCAN = 0, LT_ENGINE_HULL_TREE = 1 };
+enum { LT_TOPOLOGY_EDGES = 0, LT_TOPOLOGY_TRIANGLES = 1, LT_TOPOLOGY_HALF_EDGES = 2 };
+enum { LT_DIAGONAL_MAX_MIN_ANGLE = 0, LT_DIAGONAL_MIN_MAX_ANGLE = 1, LT_DIAGONAL_SHORTEST = 2 };
+enum { LT_FORMAT_BINARY = 0, LT_FORMAT_PLY = 1, LT_FORMAT_OBJ = 2, LT_FORMAT_EDGES = 3 };
+
+// Options of a triangulation. size tells the library which fields the caller knows of, so
+// lt_options_init() must fill it before any field is changed.
+typedef struct lt_options
+{
+    uint32_t size;                  // sizeof(lt_options) of the caller
+    uint32_t threads;               // Worker threads, 0 - all hardware threads
+    int32_t engine;                 // LT_ENGINE_*, the hull tree always merges equal points
+    int32_t topology;               // LT_TOPOLOGY_*
+    int32_t diagonal;               // LT_DIAGONAL_*
+    int32_t delaunay;               // Nonzero: flip the edges until the triangulation is Delaunay
+    int32_t remove_duplicates;      // Nonzero: merge points closer than duplicate_tolerance
+    int32_t reserved;
+    double duplicate_tolerance;
+} lt_options;
+
+typedef struct lt_triangulation lt_triangulation;
+
+LT_API uint32_t lt_abi_version(void);
+LT_API const char *lt_status_string(int status);
+
+// Defaults of the C++ library: Graham scan engine, triangles with neighbors, all threads
+LT_API void lt_options_init(lt_options *options);
+
+// Triangulate count points whose coordinates are stride bytes apart in x and in y, 0 for
+// packed arrays. Packed arrays are used in place, without a copy, and must stay valid until the
+// triangulation is destroyed; other strides, such as x and y interleaved, are copied once into
+// packed arrays of the library. options may be null for the defaults.
+LT_API int lt_triangulate(const double *x, const double *y, size_t count, size_t stride,
+                          const lt_options *options, lt_triangulation **out);
+LT_API int lt_triangulate_f32(const float *x, const float *y, size_t count, size_t stride,
+                              const lt_options *options, lt_triangulation **out);
+
+// Release the triangulation and every buffer it handed out views of
+LT_API void lt_destroy(lt_triangulation *triangulation);
+
+LT_API size_t lt_point_count(const lt_triangulation *triangulation);
+LT_API size_t lt_layer_count(const lt_triangulation *triangulation);
+LT_API size_t lt_triangle_count(const lt_triangulation *triangulation);
+
+// Every edge once, the layer sides included
+LT_API size_t lt_edge_count(const lt_triangulation *triangulation);
+
+// Views of the results, owned by the triangulation and valid until lt_destroy(). Triangles are
+// counterclockwise vertex triples, neighbors the triangle across every edge of them (null for
+// the edges topology), layers counterclockwise from the outermost: layer l is points
+// [offsets[l], offsets[l + 1]) of lt_layer_points(), offsets has lt_layer_count() + 1 values.
+LT_API const uint32_t *lt_triangles(const lt_triangulation *triangulation);
+LT_API const uint32_t *lt_neighbors(const lt_triangulation *triangulation);
+LT_API const uint32_t *lt_layer_points(const lt_triangulation *triangulation);
+LT_API const size_t *lt_layer_offsets(const lt_triangulation *triangulation);
+
+// Write the edges as vertex pairs into a caller buffer of capacity pairs, 2 * capacity values
+LT_API int lt_copy_edges(const lt_triangulation *triangulation, uint32_t *pairs, size_t capacity);
+
+// Allocate a buffer of lt_edge_count() vertex pairs and fill it; the caller owns it and must
+// release it with lt_free_buffer(), also after the triangulation is destroyed
+LT_API int lt_export_edges(const lt_triangulation *triangulation, uint32_t **pairs, size_t *count);
+LT_API void lt_free_buffer(void *buffer);
+
+// Triangle of every query point into triangles[count], LT_NONE outside the convex hull.
+// Coordinates are strided as for lt_triangulate(). Not safe to call concurrently on one
+// triangulation, as the first call builds the location index.
+LT_API int lt_locate(lt_triangulation *triangulation, const double *x, const double *y, size_t count,
+                     size_t stride, uint32_t *triangles);
+
+// Write the points and results in one of the mesh formats (LT_FORMAT_*)
+LT_API int lt_save(const lt_triangulation *triangulation, const char *filename, int format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPI_H
@@ -0,0 +1,23 @@
+# Shared library with the C interface of capi.h. Only the lt_ functions are exported, the C++
+# classes stay internal, so the library can be swapped without recompiling its callers as long
+# as LT_ABI_VERSION stays the same.
+
+TEMPLATE = lib
+TARGET = layertriangulation
+VERSION = 1.0.0
+CONFIG += shared
+CONFIG -= qt
+
+DEFINES += LT_BUILD_SHARED
+
+unix {
+    QMAKE_CXXFLAGS += -fvisibility=hidden -fvisibility-inlines-hidden
+}
+
+include(triangulation.pri)
+
+HEADERS += \
+    capi.h
+
+SOURCES += \
+    capi.cpp
@@ -0,0 +1,14 @@
+# Static library with the C interface of capi.h, for linking it into a service directly
+
+TEMPLATE = lib
+TARGET = layertriangulation
+CONFIG += staticlib
+CONFIG -= qt
+
+include(triangulation.pri)
+
+HEADERS += \
+    capi.h
+
+SOURCES += \
+    capi.cpp
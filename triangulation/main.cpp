@@ -1,9 +1,10 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-
-#include <random>
-#include <iterator>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <string>
 
 using namespace std;
 
@@ -11,6 +12,9 @@ using namespace std;
 
 #include "Point2D.h"
 #include "LayerTriangulation.h"
+#include "PointIO.h"
+#include "ThreadPool.h"
+#include "TiledTriangulation.h"
 
 std::vector<Point2D> setup_data() {
     std::vector<Point2D> data = {
@@ -26,18 +30,239 @@ std::vector<Point2D> setup_data() {
     return data;
 }
 
+void usage(const char *program) {
+    cerr << "Usage: " << program << " [options] [input]\n"
+            "Triangulates the points of input, or a small built-in example without it.\n\n"
+            "Input:\n"
+            "  --format auto|pts|f64|f32|text  input format (auto: .csv/.xyz/.txt are text, anything else pts)\n\n"
+            "Triangulation:\n"
+            "  --threads N                     worker threads, 0 - all hardware threads (default)\n"
+            "  --engine graham|hull-tree       convex layers engine (default graham)\n"
+            "  --topology edges|triangles|half-edges\n"
+            "  --diagonal min-angle|max-angle|shortest\n"
+            "                                  strip diagonals: largest smallest angle (default),\n"
+            "                                  smallest largest angle or shorter diagonal\n"
+            "  --delaunay                      flip the edges until the triangulation is Delaunay\n"
+            "  --dedup TOLERANCE               merge points closer than TOLERANCE along both axes, 0 - equal\n"
+            "                                  points only\n"
+            "  --tiled BYTES                   out of core: stream input in slabs of about BYTES of memory\n"
+            "                                  to the compact binary --output, without neighbors\n\n"
+            "Output:\n"
+            "  --output FILE                   mesh file, .ply - binary PLY, .obj - OBJ, .lte - delta-encoded\n"
+            "                                  edges only, anything else compact binary\n"
+            "  --order input|hilbert|morton|layers\n"
+            "                                  vertex numbering of the mesh file, triangles and edges follow it\n"
+            "  --latex FILE                    TikZ picture of the layers and edges\n"
+            "  --stats FILE                    phase times and counters as JSON, - for stdout\n";
+}
+
+// Set value to the one of values named name, false for an unknown name
+template <typename Value, size_t Count>
+bool parseName(const char *name, const char *const (&names)[Count], const Value (&values)[Count], Value &value) {
+    for (size_t i = 0; i < Count; ++i) {
+        if (strcmp(name, names[i]) == 0) {
+            value = values[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseFormat(const char *name, PointFormat &format) {
+    const char *const names[] = { "auto", "pts", "f64", "f32", "text" };
+    const PointFormat formats[] = { POINTS_AUTO, POINTS_BINARY, POINTS_RAW_F64, POINTS_RAW_F32, POINTS_TEXT };
+    return parseName(name, names, formats, format);
+}
+
+bool parseEngine(const char *name, LayerEngine &engine) {
+    const char *const names[] = { "graham", "hull-tree" };
+    const LayerEngine engines[] = { LAYERS_GRAHAM_SCAN, LAYERS_HULL_TREE };
+    return parseName(name, names, engines, engine);
+}
+
+bool parseTopology(const char *name, MeshTopology &topology) {
+    const char *const names[] = { "edges", "triangles", "half-edges" };
+    const MeshTopology topologies[] = { MESH_EDGES_ONLY, MESH_TRIANGLES, MESH_HALF_EDGES };
+    return parseName(name, names, topologies, topology);
+}
+
+bool parseDiagonal(const char *name, DiagonalRule &rule) {
+    const char *const names[] = { "min-angle", "max-angle", "shortest" };
+    const DiagonalRule rules[] = { DIAGONAL_MAX_MIN_ANGLE, DIAGONAL_MIN_MAX_ANGLE, DIAGONAL_SHORTEST };
+    return parseName(name, names, rules, rule);
+}
+
+bool parseOrder(const char *name, MeshOrder &order) {
+    const char *const names[] = { "input", "hilbert", "morton", "layers" };
+    const MeshOrder orders[] = { MESH_ORDER_INPUT, MESH_ORDER_HILBERT, MESH_ORDER_MORTON, MESH_ORDER_LAYERS };
+    return parseName(name, names, orders, order);
+}
 
-int main()
+MeshFormat meshFormat(const string &filename) {
+    string extension = filename.size() >= 4 ? filename.substr(filename.size() - 4) : string();
+    for (char &c : extension)
+        c = (char)tolower(c);
+    if (extension == ".lte")
+        return MESH_FORMAT_EDGES;
+    return extension == ".ply" ? MESH_FORMAT_PLY : extension == ".obj" ? MESH_FORMAT_OBJ : MESH_FORMAT_BINARY;
+}
+
+int main(int argc, char *argv[])
 {
+    TriangulationOptions options;
+    PointFormat format = POINTS_AUTO;
+    string input, output, latex, stats;
+    size_t tiled = 0;
+    MeshOrder order = MESH_ORDER_INPUT;
+
+    for (int arg = 1; arg < argc; ++arg) {
+        string name = argv[arg];
+        bool has_value = arg + 1 < argc;
+
+        if (name == "--format" && has_value) {
+            if (!parseFormat(argv[++arg], format)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (name == "--threads" && has_value) {
+            options.threads = (unsigned)atoi(argv[++arg]);
+        } else if (name == "--engine" && has_value) {
+            if (!parseEngine(argv[++arg], options.layerEngine)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (name == "--topology" && has_value) {
+            if (!parseTopology(argv[++arg], options.topology)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (name == "--diagonal" && has_value) {
+            if (!parseDiagonal(argv[++arg], options.diagonalRule)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (name == "--delaunay") {
+            options.delaunayFlips = true;
+        } else if (name == "--dedup" && has_value) {
+            options.removeDuplicates = true;
+            options.duplicateTolerance = atof(argv[++arg]);
+        } else if (name == "--tiled" && has_value) {
+            tiled = (size_t)strtoull(argv[++arg], nullptr, 10);
+        } else if (name == "--output" && has_value) {
+            output = argv[++arg];
+        } else if (name == "--order" && has_value) {
+            if (!parseOrder(argv[++arg], order)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (name == "--stats" && has_value) {
+            stats = argv[++arg];
+        } else if (name == "--latex" && has_value) {
+            latex = argv[++arg];
+        } else if (name[0] != '-' && input.empty()) {
+            input = name;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (input.empty()) {
+        std::vector<Point2D> data = setup_data();
+
+        Timer timer;
+        LayerTriangulation triangulation(data, options);
+        std::cout << timer.elapsed() * 1000 << " ms" << std::endl;
+
+        triangulation.saveLaTeX(latex.empty() ? "latex_output.tex" : latex, data);
+        return 0;
+    }
 
-    std::vector<Point2D> data = setup_data();
+    if (tiled > 0) {
+        if (output.empty()) {
+            usage(argv[0]);
+            return 1;
+        }
+        TiledOptions tiled_options;
+        tiled_options.triangulation = options;
+        tiled_options.memoryBudget = tiled;
+        TiledStats tiled_stats;
+        if (!triangulateTiled(input, format, output, tiled_options, tiled_stats)) {
+            cerr << "Cannot triangulate " << input << " into " << output << endl;
+            return 1;
+        }
+        cout << "points:        " << tiled_stats.points << "\n"
+             << "slabs:         " << tiled_stats.slabs << " (largest " << tiled_stats.largestSlab << " points)\n"
+             << "edges:         " << tiled_stats.edges << "\n"
+             << "triangles:     " << tiled_stats.triangles << "\n"
+             << "partition:     " << tiled_stats.partitionTime * 1000 << " ms\n"
+             << "triangulation: " << tiled_stats.triangulationTime * 1000 << " ms\n"
+             << "seams:         " << tiled_stats.seamTime * 1000 << " ms\n"
+             << "total:         " << tiled_stats.totalTime * 1000 << " ms\n"
+             << "peak memory:   " << tiled_stats.peakMemory << " bytes" << endl;
+        return 0;
+    }
+
+    // One pool serves loading and triangulation
+    ThreadPool pool(options.threads);
+    options.pool = &pool;
 
     Timer timer;
-    LayerTriangulation triangulation(data);
-    std::cout << timer.elapsed() * 1000 << " ms" << std::endl;
+    PointCloud cloud;
+    if (!cloud.load(input, format, &pool)) {
+        cerr << "Cannot read points from " << input << endl;
+        return 1;
+    }
+    double load_time = timer.elapsed();
+
+    timer.reset();
+    LayerTriangulation triangulation(cloud.x, cloud.y, cloud.size(), options);
+    double triangulation_time = timer.elapsed();
+    triangulation.releaseWorkspace();
+
+    cout << "points:        " << cloud.size() << "\n"
+         << "layers:        " << triangulation.layers.size() << "\n"
+         << "edges:         " << triangulation.edges.size() << "\n"
+         << "triangles:     " << triangulation.mesh.size() << "\n"
+         << "load:          " << load_time * 1000 << " ms\n"
+         << "triangulation: " << triangulation_time * 1000 << " ms" << endl;
 
-    triangulation.saveLaTeX(“latex_output.tex”, data);
+    if (stats == "-") {
+        cout << triangulation.stats.toJSON() << endl;
+    } else if (!stats.empty()) {
+        ofstream out(stats);
+        if (!(out << triangulation.stats.toJSON() << endl)) {
+            cerr << "Cannot write " << stats << endl;
+            return 1;
+        }
+    }
+
+    if (!output.empty()) {
+        timer.reset();
+        bool saved;
+        if (order == MESH_ORDER_INPUT) {
+            saved = triangulation.saveMesh(output, meshFormat(output));
+        } else {
+            OrderedMesh ordered;
+            triangulation.orderMesh(order, ordered);
+            saved = ordered.save(output, meshFormat(output));
+        }
+        if (!saved) {
+            cerr << "Cannot write " << output << endl;
+            return 1;
+        }
+        cout << "output:        " << timer.elapsed() * 1000 << " ms" << endl;
+    }
+
+    if (!latex.empty()) {
+        std::vector<Point2D> points(cloud.size());
+        for (size_t i = 0; i < points.size(); ++i)
+            points[i] = Point2D(cloud.x[i], cloud.y[i]);
+        if (!triangulation.saveLaTeX(latex, points)) {
+            cerr << "Cannot write " << latex << endl;
+            return 1;
+        }
+    }
 
     return 0;
 }
-
@@ -0,0 +1,62 @@
+# Sources shared by the command-line driver and the benchmark
+
+CONFIG += c++17
+
+# Uncomment to compile the instrumentation out
+# DEFINES += TRIANGULATION_NO_STATS
+
+win32: LIBS += -lpsapi
+
+unix {
+    QMAKE_CXXFLAGS += -pthread
+    LIBS += -pthread
+}
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/Point2D.h \
+    $$PWD/Defs.h \
+    $$PWD/LayerTriangulation.h \
+    $$PWD/BatchTriangulation.h \
+    $$PWD/TiledTriangulation.h \
+    $$PWD/Timer.h \
+    $$PWD/ThreadPool.h \
+    $$PWD/RadixSort.h \
+    $$PWD/AngularSort.h \
+    $$PWD/ConvexLayers.h \
+    $$PWD/DiagonalRules.h \
+    $$PWD/Duplicates.h \
+    $$PWD/EdgeFlips.h \
+    $$PWD/LayerList.h \
+    $$PWD/PointArray.h \
+    $$PWD/PointKernels.h \
+    $$PWD/TriangleMesh.h \
+    $$PWD/TriangulationWorkspace.h \
+    $$PWD/PointIO.h \
+    $$PWD/MeshIO.h \
+    $$PWD/MeshOrder.h \
+    $$PWD/PointLocation.h \
+    $$PWD/Generators.h \
+    $$PWD/Stats.h \
+    $$PWD/Predicates.h
+
+SOURCES += \
+    $$PWD/Point2D.cpp \
+    $$PWD/LayerTriangulation.cpp \
+    $$PWD/BatchTriangulation.cpp \
+    $$PWD/TiledTriangulation.cpp \
+    $$PWD/ThreadPool.cpp \
+    $$PWD/RadixSort.cpp \
+    $$PWD/AngularSort.cpp \
+    $$PWD/ConvexLayers.cpp \
+    $$PWD/Duplicates.cpp \
+    $$PWD/EdgeFlips.cpp \
+    $$PWD/PointKernels.cpp \
+    $$PWD/PointIO.cpp \
+    $$PWD/MeshIO.cpp \
+    $$PWD/MeshOrder.cpp \
+    $$PWD/PointLocation.cpp \
+    $$PWD/Generators.cpp \
+    $$PWD/Stats.cpp \
+    $$PWD/Predicates.cpp
@@ -2,17 +2,8 @@ TEMPLATE = app
 CONFIG += console
 CONFIG += app_bundle
 CONFIG -= qt
-CONFIG += c++11
-
-HEADERS += \
-    Point2D.h \
-    Defs.h \
-    LayerTriangulation.h \
-    Timer.h
 
+include(triangulation.pri)
 
 SOURCES += \
-    main.cpp \
-    Point2D.cpp \
-    LayerTriangulation.cpp
-
+    main.cpp